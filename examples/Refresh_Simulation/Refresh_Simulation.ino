@@ -0,0 +1,145 @@
+/**
+ * Created by K. Suwatchai (Mobizt)
+ *
+ * Email: k_suwatchai@hotmail.com
+ *
+ * Github: https://github.com/mobizt
+ *
+ * Copyright (c) 2023 mobizt
+ *
+ */
+
+// This example simulates the token requests of many devices that were started at the same time
+// and shows the number of requests per minute with and without the refresh jitter and retry backoff.
+// The same GAuth_Refresh_Scheduler is used by the library with
+// config.signer.refreshJitterSeconds, config.timeout.tokenRequestRetry and config.timeout.tokenRequestRetryMax.
+
+#include <Arduino.h>
+#include <ESP_Signer.h>
+
+// The number of simulated devices
+#define DEVICES 1000
+
+// The token lifetime and pre-refresh seconds
+#define TOKEN_LIFETIME 3600
+#define PRE_REFRESH_SECONDS 60
+
+// The maximum refresh jitter seconds
+#define REFRESH_JITTER_SECONDS 600
+
+// The token server is not available for this period after all devices were started
+#define OUTAGE_SECONDS 600
+
+// The first and maximum retry interval in ms
+#define RETRY_BASE_MS 5000
+#define RETRY_MAX_MS 60000
+
+#define BUCKETS 60
+
+// The number of requests per minute
+uint16_t buckets[BUCKETS];
+
+GAuth_Refresh_Scheduler scheduler;
+
+uint32_t deviceSeed(int device)
+{
+    // The seed of each device, the library uses the chip id by default
+    return 0x9e3779b9 * (uint32_t)(device + 1);
+}
+
+void count(unsigned long seconds)
+{
+    if (seconds / 60 < BUCKETS)
+        buckets[seconds / 60]++;
+}
+
+void printResult(const char *name, int minutes)
+{
+    unsigned long total = 0;
+    int peak = 0, busy = 0;
+
+    for (int i = 0; i < BUCKETS; i++)
+    {
+        total += buckets[i];
+        if (buckets[i] > peak)
+            peak = buckets[i];
+        if (buckets[i] > 0)
+            busy++;
+    }
+
+    Serial.println();
+    Serial.println(name);
+    Serial.print("Total requests: ");
+    Serial.print((int)total);
+    Serial.print(", peak requests per minute: ");
+    Serial.print(peak);
+    Serial.print(", minutes with requests: ");
+    Serial.println(busy);
+
+    Serial.print("Requests per minute: ");
+    for (int i = 0; i < minutes && i < BUCKETS; i++)
+    {
+        Serial.print(buckets[i]);
+        Serial.print(" ");
+    }
+    Serial.println();
+}
+
+void simulateRefresh(unsigned long jitter)
+{
+    memset(buckets, 0, sizeof(buckets));
+
+    // All tokens were issued at the same time
+    unsigned long expires = 1700000000 + TOKEN_LIFETIME;
+
+    for (int i = 0; i < DEVICES; i++)
+    {
+        scheduler.begin(deviceSeed(i));
+        count(TOKEN_LIFETIME - scheduler.refreshLead(PRE_REFRESH_SECONDS, jitter, expires));
+    }
+
+    printResult(jitter > 0 ? "Refresh with jitter" : "Refresh without jitter", BUCKETS);
+}
+
+void simulateOutage(bool backoff)
+{
+    memset(buckets, 0, sizeof(buckets));
+
+    for (int i = 0; i < DEVICES; i++)
+    {
+        scheduler.begin(deviceSeed(i));
+
+        unsigned long ms = 0;
+
+        // The failed requests
+        while (ms < OUTAGE_SECONDS * 1000UL)
+        {
+            count(ms / 1000);
+            ms += backoff ? scheduler.failed(RETRY_BASE_MS, RETRY_MAX_MS, 0) : RETRY_BASE_MS;
+        }
+
+        // The successful request
+        count(ms / 1000);
+    }
+
+    printResult(backoff ? "Server outage, retry with backoff" : "Server outage, retry with fixed interval", 15);
+}
+
+void setup()
+{
+    Serial.begin(115200);
+    Serial.println();
+
+    Serial.print("Devices: ");
+    Serial.println(DEVICES);
+
+    simulateRefresh(0);
+    simulateRefresh(REFRESH_JITTER_SECONDS);
+
+    simulateOutage(false);
+    simulateOutage(true);
+}
+
+void loop()
+{
+}
@@ -41,6 +41,7 @@ ESP_Signer::ESP_Signer()
 {
     authClient.begin(nullptr, &mbfs, &mb_ts, &mb_ts_offset);
     authClient.newClient(&authClient.tcpClient);
+    tokenManager.begin(&authClient, &mbfs, &mb_ts, &mb_ts_offset);
 }
 
 ESP_Signer::~ESP_Signer()
@@ -62,13 +63,15 @@ void ESP_Signer::begin(SignerConfig *cfg)
 #if defined(ESP32) || defined(ESP8266)
     config->internal.reconnect_wifi = WiFi.getAutoReconnect();
 #endif
-    config->signer.tokens.token_type = token_type_oauth2_access_token;
+    if (config->signer.tokens.token_type != token_type_self_signed_jwt)
+        config->signer.tokens.token_type = token_type_oauth2_access_token;
 
     authClient.begin(config, &mbfs, &mb_ts, &mb_ts_offset);
 }
 
 void ESP_Signer::end()
 {
+    tokenManager.end();
     authClient.end();
 }
 
@@ -79,6 +82,11 @@ String ESP_Signer::accessToken()
     return config->internal.auth_token.c_str();
 }
 
+String ESP_Signer::selfSignedJWT(const char *audience)
+{
+    return authClient.getSelfSignedJWT(audience);
+}
+
 void ESP_Signer::mSetClient(Client *client, ESP_Signer_NetworkConnectionRequestCallback networkConnectionCB,
                             ESP_Signer_NetworkStatusRequestCallback networkStatusCB)
 {
@@ -88,9 +96,67 @@ void ESP_Signer::mSetClient(Client *client, ESP_Signer_NetworkConnectionRequestC
 
 bool ESP_Signer::tokenReady()
 {
+    tokenManager.loop();
+
+    // the token manager entry is sending its request with the same TCP client
+    if (tokenManager.connectionBusy())
+        return config && config->signer.tokens.status == esp_signer_token_status_ready;
+
     return authClient.tokenReady();
 };
 
+int ESP_Signer::addToken(SignerConfig *config)
+{
+    return tokenManager.add(config);
+}
+
+bool ESP_Signer::removeToken(int handle)
+{
+    return tokenManager.remove(handle);
+}
+
+bool ESP_Signer::tokenReady(int handle)
+{
+    return tokenManager.tokenReady(handle);
+}
+
+String ESP_Signer::accessToken(int handle)
+{
+    return tokenManager.accessToken(handle);
+}
+
+TokenView ESP_Signer::accessTokenView()
+{
+    return authClient.tokenSlot.view();
+}
+
+TokenView ESP_Signer::accessTokenView(int handle)
+{
+    return tokenManager.accessTokenView(handle);
+}
+
+size_t ESP_Signer::copyAccessToken(char *buf, size_t size)
+{
+    if (!buf || size == 0)
+        return 0;
+    return authClient.tokenSlot.copy(buf, size);
+}
+
+size_t ESP_Signer::copyAccessToken(int handle, char *buf, size_t size)
+{
+    return tokenManager.copyAccessToken(handle, buf, size);
+}
+
+bool ESP_Signer::requestTokenAsync(TokenRequestCallback callback, void *arg)
+{
+    return authClient.requestTokenAsync(callback, arg);
+}
+
+bool ESP_Signer::requestTokenAsync(int handle, TokenRequestCallback callback, void *arg)
+{
+    return tokenManager.requestTokenAsync(handle, callback, arg);
+}
+
 String ESP_Signer::getTokenType(TokenInfo info)
 {
     return authClient.getTokenType(info);
@@ -121,6 +187,46 @@ String ESP_Signer::getTokenError()
     return authClient.getTokenError();
 }
 
+const TokenInfo &ESP_Signer::getTokenInfo()
+{
+    return authClient.getTokenInfo();
+}
+
+const __FlashStringHelper *ESP_Signer::getTokenTypeF(const TokenInfo &info)
+{
+    return GAuth_OAuth2_Client::tokenTypeString(info.type);
+}
+
+const __FlashStringHelper *ESP_Signer::getTokenTypeF()
+{
+    return getTokenTypeF(authClient.getTokenInfo());
+}
+
+const __FlashStringHelper *ESP_Signer::getTokenStatusF(const TokenInfo &info)
+{
+    return GAuth_OAuth2_Client::tokenStatusString(info.status);
+}
+
+const __FlashStringHelper *ESP_Signer::getTokenStatusF()
+{
+    return getTokenStatusF(authClient.getTokenInfo());
+}
+
+const char *ESP_Signer::getTokenErrorMessage(const TokenInfo &info)
+{
+    return authClient.getTokenErrorMessage(info);
+}
+
+const char *ESP_Signer::getTokenErrorMessage()
+{
+    return getTokenErrorMessage(authClient.getTokenInfo());
+}
+
+const __FlashStringHelper *ESP_Signer::getErrorString(int code)
+{
+    return GAuth_OAuth2_Client::errorString(code);
+}
+
 unsigned long ESP_Signer::getExpiredTimestamp()
 {
     return authClient.getExpiredTimestamp();
@@ -38,6 +38,7 @@
 #include "mbfs/MB_MCU.h"
 #include "ESP_Signer_Helper.h"
 #include "auth/GAuth_OAuth2_Client.h"
+#include "auth/GAuth_Token_Manager.h"
 
 class ESP_Signer
 {
@@ -106,9 +107,41 @@ public:
      *
      * @return Boolean of ready state.
      *
+     * The expired token of the additional credentials (see addToken) will be processed here too.
+     *
      */
     bool tokenReady();
 
+    /**
+     * Add the additional service account credentials and scopes.
+     *
+     * @param config The pointer to SignerConfig structured data contains the authentication credentials
+     * @return The token handle or -1 when ESP_SIGNER_MAX_TOKEN_ENTRIES was reached.
+     *
+     * The credentials that have the same private key, client email and scopes share the same handle.
+     * The config should be existed as long as its handle was used.
+     *
+     */
+    int addToken(SignerConfig *config);
+
+    /**
+     * Remove the additional service account credentials.
+     *
+     * @param handle The token handle from addToken.
+     * @return Boolean type status indicates the success of the operation.
+     *
+     */
+    bool removeToken(int handle);
+
+    /**
+     * Check the token ready state of the additional credentials.
+     *
+     * @param handle The token handle from addToken.
+     * @return Boolean of ready state.
+     *
+     */
+    bool tokenReady(int handle);
+
     /**
      * Get the generated access token.
      *
@@ -117,6 +150,98 @@ public:
      */
     String accessToken();
 
+    /**
+     * Get the generated access token of the additional credentials.
+     *
+     * @param handle The token handle from addToken.
+     * @return String of OAuth2.0 access token.
+     *
+     */
+    String accessToken(int handle);
+
+    /**
+     * Get the access token without copy.
+     *
+     * @return The TokenView of the token, its length and generation.
+     *
+     * This can be called from other tasks or cores while the token is refreshed.
+     * The generation is increased when the token was replaced. The view memory is kept until end(),
+     * its token is unchanged until the token was replaced twice, use copyAccessToken to keep the token.
+     *
+     */
+    TokenView accessTokenView();
+
+    /**
+     * Get the access token of the additional credentials without copy.
+     *
+     * @param handle The token handle from addToken.
+     * @return The TokenView of the token, its length and generation.
+     *
+     */
+    TokenView accessTokenView(int handle);
+
+    /**
+     * Copy the access token into the buffer.
+     *
+     * @param buf The buffer.
+     * @param size The buffer size.
+     * @return The token length, 0 when no token, or the required buffer size when the buffer is too small.
+     *
+     * This can be called from other tasks or cores, the token that was replaced while copying is copied again.
+     *
+     */
+    size_t copyAccessToken(char *buf, size_t size);
+
+    /**
+     * Copy the access token of the additional credentials into the buffer.
+     *
+     * @param handle The token handle from addToken.
+     * @param buf The buffer.
+     * @param size The buffer size.
+     * @return The token length, 0 when no token, or the required buffer size when the buffer is too small.
+     *
+     */
+    size_t copyAccessToken(int handle, char *buf, size_t size);
+
+    /**
+     * Request the access token without waiting for it.
+     *
+     * @param callback The TokenRequestCallback function that receives the token status and the token.
+     * @param arg The user data that is passed to the callback.
+     * @return Boolean type status indicates the callback was added.
+     *
+     * The callback is called at once when the token is ready, otherwise tokenReady() sends the token request
+     * and calls it when the request was finished. The token is empty when the request was failed.
+     * All callbacks that are waiting receive the token of the same token request.
+     *
+     */
+    bool requestTokenAsync(TokenRequestCallback callback, void *arg = nullptr);
+
+    /**
+     * Request the access token of the additional credentials without waiting for it.
+     *
+     * @param handle The token handle from addToken.
+     * @param callback The TokenRequestCallback function that receives the token status and the token.
+     * @param arg The user data that is passed to the callback.
+     * @return Boolean type status indicates the callback was added.
+     *
+     * The handles that share the same credentials and scopes share the same token request.
+     *
+     */
+    bool requestTokenAsync(int handle, TokenRequestCallback callback, void *arg = nullptr);
+
+    /**
+     * Get the self-signed JWT for the API audience.
+     *
+     * @param audience The API audience e.g. https://pubsub.googleapis.com/
+     * @return String of self-signed JWT or empty string when the private key or time is not ready.
+     *
+     * The token is signed locally without the token exchange and cached by its audience
+     * until it is going to expire.
+     *
+     */
+    String selfSignedJWT(const char *audience);
+
     /**
      * Get the token type string.
      *
@@ -147,6 +272,53 @@ public:
     String getTokenError();
     String getTokenError(TokenInfo info);
 
+    /**
+     * Get the current token info.
+     *
+     * @return the reference to TokenInfo structured data.
+     *
+     */
+    const TokenInfo &getTokenInfo();
+
+    /**
+     * Get the token type string from flash, no memory is allocated.
+     *
+     * @param info The TokenInfo structured data contains token info.
+     * @return token type flash string.
+     *
+     */
+    const __FlashStringHelper *getTokenTypeF();
+    const __FlashStringHelper *getTokenTypeF(const TokenInfo &info);
+
+    /**
+     * Get the token status string from flash, no memory is allocated.
+     *
+     * @param info The TokenInfo structured data contains token info.
+     * @return token status flash string.
+     *
+     */
+    const __FlashStringHelper *getTokenStatusF();
+    const __FlashStringHelper *getTokenStatusF(const TokenInfo &info);
+
+    /**
+     * Get the token generation error message without copy.
+     *
+     * @param info The TokenInfo structured data contains token info.
+     * @return token error message, valid until the next token request.
+     *
+     */
+    const char *getTokenErrorMessage();
+    const char *getTokenErrorMessage(const TokenInfo &info);
+
+    /**
+     * Get the error description string of the error code from flash.
+     *
+     * @param code The error code (TokenInfo.error.code).
+     * @return error description flash string, "unknown error" for the unknown code.
+     *
+     */
+    const __FlashStringHelper *getErrorString(int code);
+
     /**
      * Get the token expiration timestamp (seconds from midnight Jan 1, 1970).
      *
@@ -280,6 +452,7 @@ protected:
     SignerConfig *config = nullptr;
 
     GAuth_OAuth2_Client authClient;
+    GAuth_Token_Manager tokenManager;
     MB_FS mbfs;
     uint32_t mb_ts = 0;
     uint32_t mb_ts_offset = 0;
@@ -0,0 +1,358 @@
+/**
+ * ESP Signer Base64 v1.0.0
+ *
+ * This library supports Espressif ESP8266, ESP32 and Raspberry Pi Pico MCUs.
+ *
+ * The MIT License (MIT)
+ * Copyright (c) 2022 K. Suwatchai (Mobizt)
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person returning a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef ESP_SIGNER_BASE64_H
+#define ESP_SIGNER_BASE64_H
+
+#include <Arduino.h>
+#include <Client.h>
+#include <string.h>
+#include "mbfs/MB_FS.h"
+#include "json/MB_List.h"
+
+// The decoded data block size that is passed to the decoder sink
+#ifndef ESP_SIGNER_BASE64_DECODE_BLOCK_SIZE
+#define ESP_SIGNER_BASE64_DECODE_BLOCK_SIZE 96
+#endif
+
+/* Base64 (RFC 4648 section 4) and Base64URL (RFC 4648 section 5) codec.
+ * The alphabets and the reverse table are static tables, no table is created per call.
+ * The encoder loads the input as 32-bit big-endian words, 12 bytes (four 24-bit groups) per round,
+ * and stores each group as one 32-bit word of 4 characters.
+ * The decoder accepts the input in any fragments and passes the decoded data to the sink.
+ */
+namespace Base64Codec
+{
+    static constexpr char alphabetStd[65] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    static constexpr char alphabetURL[65] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+    inline const char *alphabet(bool url) { return url ? alphabetURL : alphabetStd; }
+
+    // the reverse table of both alphabets, 0x80 is not the Base64 character (skipped), 0x81 is the padding
+    static constexpr uint8_t invalid = 0x80;
+    static constexpr uint8_t padding = 0x81;
+    static constexpr uint8_t reverse[256] = {
+        0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+        0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+        0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x3e, 0x80, 0x3e, 0x80, 0x3f,
+        0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x3b, 0x3c, 0x3d, 0x80, 0x80, 0x80, 0x81, 0x80, 0x80,
+        0x80, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e,
+        0x0f, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x80, 0x80, 0x80, 0x80, 0x3f,
+        0x80, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28,
+        0x29, 0x2a, 0x2b, 0x2c, 0x2d, 0x2e, 0x2f, 0x30, 0x31, 0x32, 0x33, 0x80, 0x80, 0x80, 0x80, 0x80,
+        0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+        0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+        0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+        0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+        0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+        0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+        0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+        0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80};
+
+    /* the exact number of characters to encode n bytes (without null terminator) */
+    inline constexpr size_t encodedLength(size_t n, bool pad) { return pad ? (n + 2) / 3 * 4 : (n * 4 + 2) / 3; }
+
+    inline uint32_t loadBE32(const uint8_t *p)
+    {
+        uint32_t v;
+        memcpy(&v, p, 4);
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        v = __builtin_bswap32(v);
+#endif
+        return v;
+    }
+
+    /* encode the 24-bit group into 4 characters */
+    inline void encodeGroup(char *out, uint32_t v, const char *table)
+    {
+        uint32_t w = (uint32_t)(uint8_t)table[(v >> 18) & 0x3f] |
+                     ((uint32_t)(uint8_t)table[(v >> 12) & 0x3f] << 8) |
+                     ((uint32_t)(uint8_t)table[(v >> 6) & 0x3f] << 16) |
+                     ((uint32_t)(uint8_t)table[v & 0x3f] << 24);
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        w = __builtin_bswap32(w);
+#endif
+        memcpy(out, &w, 4);
+    }
+
+    /* encode the data into out which must have encodedLength(len, pad) bytes,
+     * returns the number of characters written, the output is not null terminated
+     */
+    inline size_t encode(char *out, const uint8_t *src, size_t len, bool url = false, bool pad = true)
+    {
+        const char *table = alphabet(url);
+        char *p = out;
+
+        while (len >= 12)
+        {
+            uint32_t w0 = loadBE32(src);
+            uint32_t w1 = loadBE32(src + 4);
+            uint32_t w2 = loadBE32(src + 8);
+
+            encodeGroup(p, w0 >> 8, table);
+            encodeGroup(p + 4, (w0 << 16) | (w1 >> 16), table);
+            encodeGroup(p + 8, (w1 << 8) | (w2 >> 24), table);
+            encodeGroup(p + 12, w2, table);
+
+            src += 12;
+            len -= 12;
+            p += 16;
+        }
+
+        while (len >= 3)
+        {
+            encodeGroup(p, ((uint32_t)src[0] << 16) | ((uint32_t)src[1] << 8) | src[2], table);
+            src += 3;
+            len -= 3;
+            p += 4;
+        }
+
+        // the last 1 or 2 bytes
+        if (len > 0)
+        {
+            uint32_t v = ((uint32_t)src[0] << 16) | (len > 1 ? (uint32_t)src[1] << 8 : 0);
+            *p++ = table[v >> 18];
+            *p++ = table[(v >> 12) & 0x3f];
+            if (len > 1)
+                *p++ = table[(v >> 6) & 0x3f];
+            else if (pad)
+                *p++ = '=';
+            if (pad)
+                *p++ = '=';
+        }
+
+        return p - out;
+    }
+
+    /* The output of the decoder */
+    class Sink
+    {
+    public:
+        virtual ~Sink() {}
+        virtual bool write(const uint8_t *data, size_t len) = 0;
+    };
+
+    /* Writes into the memory buffer, fails when the buffer is full */
+    class MemorySink : public Sink
+    {
+    public:
+        MemorySink(uint8_t *buf, size_t size) : buf(buf), size(size) {}
+        bool write(const uint8_t *data, size_t n) override
+        {
+            if (len + n > size)
+                return false;
+            memcpy(buf + len, data, n);
+            len += n;
+            return true;
+        }
+        size_t length() const { return len; }
+
+    private:
+        uint8_t *buf = nullptr;
+        size_t size = 0;
+        size_t len = 0;
+    };
+
+    /* Appends to the vector */
+    template <typename T>
+    class VectorSink : public Sink
+    {
+    public:
+        VectorSink(MB_VECTOR<T> *vec) : vec(vec) {}
+        bool write(const uint8_t *data, size_t n) override
+        {
+            for (size_t i = 0; i < n; i++)
+                vec->push_back((T)data[i]);
+            return true;
+        }
+
+    private:
+        MB_VECTOR<T> *vec = nullptr;
+    };
+
+    /* Writes to the client */
+    class ClientSink : public Sink
+    {
+    public:
+        ClientSink(Client *client) : client(client) {}
+        bool write(const uint8_t *data, size_t n) override { return client->write(data, n) == n; }
+
+    private:
+        Client *client = nullptr;
+    };
+
+    /* Writes to the opened file */
+    class FileSink : public Sink
+    {
+    public:
+        FileSink(MB_FS *mbfs, mbfs_file_type type) : mbfs(mbfs), type(type) {}
+        bool write(const uint8_t *data, size_t n) override { return mbfs->write(type, (uint8_t *)data, n) == (int)n; }
+
+    private:
+        MB_FS *mbfs = nullptr;
+        mbfs_file_type type;
+    };
+
+    /* The resumable decoder, push() accepts the input in any fragments and end() writes the remaining data.
+     * The characters that are not in the alphabets (e.g. line breaks) are skipped,
+     * the data after padding is ignored and the unpadded input is accepted.
+     */
+    class Decoder
+    {
+    public:
+        Decoder(Sink *sink = nullptr) { begin(sink); }
+
+        void begin(Sink *sink)
+        {
+            this->sink = sink;
+            acc = 0;
+            count = 0;
+            outLen = 0;
+            total = 0;
+            done = false;
+            err = false;
+        }
+
+        bool push(const char *data, size_t len)
+        {
+            const uint8_t *p = (const uint8_t *)data;
+
+            while (len > 0 && !done && !err)
+            {
+                // the whole groups
+                if (count == 0)
+                {
+                    while (len >= 4)
+                    {
+                        uint32_t a = reverse[p[0]], b = reverse[p[1]], c = reverse[p[2]], d = reverse[p[3]];
+                        // any of them is not a 6-bit value
+                        if ((a | b | c | d) & 0x80)
+                            break;
+                        output((a << 18) | (b << 12) | (c << 6) | d, 3);
+                        p += 4;
+                        len -= 4;
+                    }
+
+                    if (len == 0)
+                        break;
+                }
+
+                uint8_t v = reverse[*p++];
+                len--;
+
+                if (v == invalid)
+                    continue;
+
+                if (v == padding)
+                {
+                    // at least 2 characters before padding
+                    if (count < 2)
+                        err = true;
+                    else
+                        flushPartial();
+                    done = true;
+                    break;
+                }
+
+                acc = (acc << 6) | v;
+                if (++count == 4)
+                {
+                    output(acc, 3);
+                    acc = 0;
+                    count = 0;
+                }
+            }
+
+            return !err;
+        }
+
+        /* write the remaining data, returns false when the input or the sink write was failed */
+        bool end()
+        {
+            if (!done && !err)
+            {
+                if (count == 1)
+                    err = true;
+                else
+                    flushPartial();
+                done = true;
+            }
+
+            if (!err && outLen > 0)
+                flush();
+
+            return !err;
+        }
+
+        bool error() const { return err; }
+
+        /* the number of decoded bytes */
+        size_t length() const { return total; }
+
+    private:
+        Sink *sink = nullptr;
+        uint32_t acc = 0;
+        uint8_t count = 0;
+        bool done = false;
+        bool err = false;
+        size_t total = 0;
+        size_t outLen = 0;
+        uint8_t out[ESP_SIGNER_BASE64_DECODE_BLOCK_SIZE];
+
+        void output(uint32_t v, int n)
+        {
+            if (outLen + 3 > sizeof(out))
+                flush();
+            out[outLen++] = v >> 16;
+            if (n > 1)
+                out[outLen++] = v >> 8;
+            if (n > 2)
+                out[outLen++] = v;
+            total += n;
+        }
+
+        // the last 2 or 3 characters
+        void flushPartial()
+        {
+            if (count == 2)
+                output(acc << 12, 1);
+            else if (count == 3)
+                output(acc << 6, 2);
+            acc = 0;
+            count = 0;
+        }
+
+        void flush()
+        {
+            if (sink && !sink->write(out, outLen))
+                err = true;
+            outLen = 0;
+        }
+    };
+}
+
+#endif
@@ -18,6 +18,8 @@
 
 #define ESP_SIGNER_MIN_TOKEN_GENERATION_BEGIN_STEP_INTERVAL 300
 
+#define ESP_SIGNER_MAX_TOKEN_REQUEST_WAIT 5 * 1000
+
 #define ESP_SIGNER_MIN_SERVER_RESPONSE_TIMEOUT 1 * 1000
 #define ESP_SIGNER_DEFAULT_SERVER_RESPONSE_TIMEOUT 5 * 1000
 #define ESP_SIGNER_MAX_SERVER_RESPONSE_TIMEOUT 60 * 1000
@@ -25,6 +27,35 @@
 #define ESP_SIGNER_MIN_WIFI_RECONNECT_TIMEOUT 10 * 1000
 #define ESP_SIGNER_MAX_WIFI_RECONNECT_TIMEOUT 5 * 60 * 1000
 
+#define ESP_SIGNER_MAX_SELF_SIGNED_JWT_CACHE 4
+
+#ifndef ESP_SIGNER_MAX_TOKEN_ENTRIES
+#define ESP_SIGNER_MAX_TOKEN_ENTRIES 8
+#endif
+
+#ifndef ESP_SIGNER_MAX_TLS_SESSION_CACHE
+#define ESP_SIGNER_MAX_TLS_SESSION_CACHE 2
+#endif
+
+// The read size of service account file
+#ifndef ESP_SIGNER_SA_FILE_READ_WINDOW
+#define ESP_SIGNER_SA_FILE_READ_WINDOW 256
+#endif
+
+// The minimum buffer size of the token for the token view
+#ifndef ESP_SIGNER_TOKEN_SLOT_MIN_SIZE
+#define ESP_SIGNER_TOKEN_SLOT_MIN_SIZE 1024
+#endif
+
+// The stack size and priority of the token prefetch task (ESP32)
+#ifndef ESP_SIGNER_PREFETCH_TASK_STACK_SIZE
+#define ESP_SIGNER_PREFETCH_TASK_STACK_SIZE 12 * 1024
+#endif
+
+#ifndef ESP_SIGNER_PREFETCH_TASK_PRIORITY
+#define ESP_SIGNER_PREFETCH_TASK_PRIORITY 1
+#endif
+
 #include <Arduino.h>
 #include "mbfs/MB_MCU.h"
 #include "ESP_Signer_Error.h"
@@ -118,6 +149,15 @@ typedef enum
 
 } esp_signer_cert_type;
 
+typedef enum
+{
+    esp_signer_rsa_engine_auto,
+    esp_signer_rsa_engine_i15,
+    esp_signer_rsa_engine_i31,
+    esp_signer_rsa_engine_i62
+
+} esp_signer_rsa_engine;
+
 enum esp_signer_gauth_auth_token_status
 {
     esp_signer_token_status_uninitialized,
@@ -133,7 +173,8 @@ enum esp_signer_gauth_auth_token_type
 {
     token_type_undefined,
     token_type_oauth2_access_token,
-    token_type_refresh_token
+    token_type_refresh_token,
+    token_type_self_signed_jwt
 };
 
 enum esp_signer_gauth_jwt_generation_step
@@ -144,6 +185,21 @@ enum esp_signer_gauth_jwt_generation_step
     esp_signer_gauth_jwt_generation_step_exchange
 };
 
+enum esp_signer_gauth_request_state
+{
+    esp_signer_gauth_request_state_connect,
+    esp_signer_gauth_request_state_send,
+    esp_signer_gauth_request_state_receive
+};
+
+enum esp_signer_gauth_prefetch_state
+{
+    esp_signer_gauth_prefetch_state_idle,
+    esp_signer_gauth_prefetch_state_running,
+    esp_signer_gauth_prefetch_state_done,
+    esp_signer_gauth_prefetch_state_failed
+};
+
 enum esp_signer_request_method
 {
     http_undefined,
@@ -212,8 +268,9 @@ struct esp_signer_gauth_auth_token_error_t
 struct esp_signer_gauth_auth_token_info_t
 {
     MB_String auth_type;
-    MB_String jwt;
     MB_String scope;
+    /* the API audience of self-signed JWT e.g. https://pubsub.googleapis.com/ */
+    MB_String audience;
     unsigned long expires = 0;
     /* milliseconds count when last expiry time was set */
     unsigned long last_millis = 0;
@@ -222,6 +279,13 @@ struct esp_signer_gauth_auth_token_info_t
     struct esp_signer_gauth_auth_token_error_t error;
 };
 
+struct esp_signer_gauth_jwt_cache_item_t
+{
+    MB_String audience;
+    MB_String token;
+    unsigned long expires = 0;
+};
+
 typedef struct esp_signer_gauth_token_info_t
 {
     esp_signer_gauth_auth_token_type type = token_type_undefined;
@@ -237,25 +301,52 @@ struct esp_signer_gauth_token_signer_resources_t
     unsigned long lastReqMillis = 0;
     unsigned long preRefreshSeconds = ESP_SIGNER_DEFAULT_AUTH_TOKEN_PRE_REFRESH_SECONDS;
     unsigned long expiredSeconds = ESP_SIGNER_DEFAULT_AUTH_TOKEN_EXPIRED_SECONDS;
+    /* seconds before expiry to sign and exchange the next token while the current token is still used, 0 to disable */
+    unsigned long prefetchSeconds = 0;
     /* request time out period (interval) */
     unsigned long reqTO = ESP_SIGNER_DEFAULT_REQUEST_TIMEOUT;
+    /* the maximum random seconds that are added to preRefreshSeconds to spread the refresh time of many devices, 0 to disable */
+    unsigned long refreshJitterSeconds = 0;
+    /* the seed of the refresh jitter and retry backoff, 0 for the chip id (ESP32 and ESP8266) */
+    uint32_t jitterSeed = 0;
+    /* the time budget in ms of one token processing call, the token processing advances by one step per call when it is set, 0 to process the token at once */
+    unsigned long stepBudgetMs = 0;
     MB_String customHeaders;
+    /* keep the TLS connection to the token endpoint open between token requests */
+    bool keepAlive = false;
+    /* the BearSSL big integer implementation for RSA signing */
+    esp_signer_rsa_engine rsaEngine = esp_signer_rsa_engine_auto;
     MB_String pk;
     size_t hashSize = 32; // SHA256 size (256 bits or 32 bytes)
+    /* the signature size of the private key, set when the key was loaded */
     size_t signatureSize = 256;
 
-    char *hash = nullptr;
-    unsigned char *signature = nullptr;
-    MB_String encHeader;
-    MB_String encPayload;
-    MB_String encHeadPayload;
-    MB_String encSignature;
-
     esp_signer_gauth_auth_token_info_t tokens;
 };
 
 typedef void (*TokenStatusCallback)(TokenInfo);
 
+/* the token status callback without the TokenInfo copy */
+typedef void (*TokenStatusRefCallback)(const TokenInfo &);
+
+/* The access token without copy, the generation is increased when the token was replaced */
+typedef struct esp_signer_gauth_token_view_t
+{
+    const char *token = "";
+    size_t length = 0;
+    uint32_t generation = 0;
+} TokenView;
+
+/* the token and its status that is delivered to the waiter of requestTokenAsync without the TokenInfo copy,
+the token is empty when it was failed */
+typedef void (*TokenRequestCallback)(const TokenInfo &info, const char *token, void *arg);
+
+struct esp_signer_gauth_token_waiter_t
+{
+    TokenRequestCallback callback = NULL;
+    void *arg = nullptr;
+};
+
 struct esp_signer_chunk_state_info
 {
     int state = 0;
@@ -342,23 +433,6 @@ struct esp_signer_server_response_data_t
     MB_String transferEnc;
 };
 
-template <typename T>
-struct esp_signer_base64_io_t
-{
-    // the total bytes of data in output buffer
-    int bufWrite = 0;
-    // the size of output buffer
-    size_t bufLen = 1024;
-    // for file, the type of filesystem to write
-    mbfs_file_type filetype = mb_fs_mem_storage_type_undefined;
-    // for T array
-    T *outT = nullptr;
-    // for T vector
-    MB_VECTOR<T> *outL = nullptr;
-    // for client
-    Client *outC = nullptr;
-};
-
 struct esp_signer_gauth_auth_cert_t
 {
     const char *data = "";
@@ -366,6 +440,20 @@ struct esp_signer_gauth_auth_cert_t
     esp_signer_mem_storage_type file_storage = esp_signer_mem_storage_type_flash;
 };
 
+struct esp_signer_gauth_tls_session_cfg_t
+{
+    /* the file to keep the TLS sessions for resumption after restart or deep sleep, empty for memory only */
+    MB_String file;
+    esp_signer_mem_storage_type file_storage = esp_signer_mem_storage_type_flash;
+};
+
+struct esp_signer_gauth_token_cache_cfg_t
+{
+    /* the file to keep the access token for reuse after restart or deep sleep, empty to disable */
+    MB_String file;
+    esp_signer_mem_storage_type file_storage = esp_signer_mem_storage_type_flash;
+};
+
 struct esp_signer_gauth_cfg_int_t
 {
     bool processing = false;
@@ -411,6 +499,12 @@ struct esp_signer_gauth_client_timeout_t
 
     uint16_t tokenGenerationError = 5 * 1000;
 
+    // The first retry interval in ms of the failed token request.
+    unsigned long tokenRequestRetry = 5 * 1000;
+
+    // The maximum retry interval in ms, the interval grows with the decorrelated jitter up to this value.
+    unsigned long tokenRequestRetryMax = 60 * 1000;
+
     uint16_t ntpServerRequest = 15 * 1000;
 };
 
@@ -515,9 +609,12 @@ struct esp_signer_gauth_cfg_t
     struct esp_signer_gauth_service_account_t service_account;
     float time_zone = 0;
     struct esp_signer_gauth_auth_cert_t cert;
+    struct esp_signer_gauth_tls_session_cfg_t tls_session;
+    struct esp_signer_gauth_token_cache_cfg_t token_cache;
     struct esp_signer_gauth_token_signer_resources_t signer;
     struct esp_signer_gauth_cfg_int_t internal;
     TokenStatusCallback token_status_callback = NULL;
+    TokenStatusRefCallback token_status_ref_callback = NULL;
     esp_signer_gauth_spi_ethernet_module_t spi_ethernet_module;
     struct esp_signer_gauth_client_timeout_t timeout;
 
@@ -541,8 +638,6 @@ typedef void (*ESP_Signer_ResponseCallback)(const char *);
 
 typedef esp_signer_gauth_cfg_t SignerConfig;
 
-static const unsigned char esp_signer_base64_table[65] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
-
 static const char esp_signer_gauth_pgm_str_1[] PROGMEM = "type";
 static const char esp_signer_gauth_pgm_str_2[] PROGMEM = "service_account";
 static const char esp_signer_gauth_pgm_str_3[] PROGMEM = "project_id";
@@ -588,6 +683,10 @@ static const char esp_signer_gauth_pgm_str_43[] PROGMEM = "error_description";
 static const char esp_signer_gauth_pgm_str_44[] PROGMEM = "access_token";
 static const char esp_signer_gauth_pgm_str_45[] PROGMEM = "Bearer ";
 static const char esp_signer_gauth_pgm_str_46[] PROGMEM = "https://www.googleapis.com/auth/cloud-platform";
+// Base64URL encoded JWT header, {"alg":"RS256","typ":"JWT"}
+static const char esp_signer_gauth_pgm_str_47[] PROGMEM = "eyJhbGciOiJSUzI1NiIsInR5cCI6IkpXVCJ9";
+// Base64URL encoded JWT header, {"alg":"ES256","typ":"JWT"}
+static const char esp_signer_gauth_pgm_str_48[] PROGMEM = "eyJhbGciOiJFUzI1NiIsInR5cCI6IkpXVCJ9";
 
 static const char esp_signer_pgm_str_1[] PROGMEM = "\r\n";
 static const char esp_signer_pgm_str_2[] PROGMEM = ".";
@@ -638,5 +737,10 @@ static const char esp_signer_pgm_str_46[] PROGMEM = "error";
 static const char esp_signer_pgm_str_47[] PROGMEM = "code: ";
 static const char esp_signer_pgm_str_48[] PROGMEM = ", message: ";
 static const char esp_signer_pgm_str_49[] PROGMEM = "ready";
+static const char esp_signer_pgm_str_50[] PROGMEM = "self-signed JWT";
+static const char esp_signer_pgm_str_51[] PROGMEM = "close";
+static const char esp_signer_pgm_str_52[] PROGMEM = "TLS2";
+static const char esp_signer_pgm_str_53[] PROGMEM = "TOK1";
+static const char esp_signer_pgm_str_54[] PROGMEM = "Retry-After: ";
 
 #endif
\ No newline at end of file
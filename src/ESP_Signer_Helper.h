@@ -16,6 +16,7 @@
 #endif
 
 #include "ESP_Signer_Const.h"
+#include "ESP_Signer_Base64.h"
 #if defined(ESP8266)
 #include <Schedule.h>
 #elif defined(MB_ARDUINO_PICO)
@@ -37,6 +38,19 @@ namespace Utils
         delay(0);
 #endif
     }
+
+    /* CRC-32 (IEEE 802.3), the crc of the previous data to continue */
+    inline uint32_t crc32(uint32_t crc, const uint8_t *data, size_t len)
+    {
+        crc = ~crc;
+        for (size_t i = 0; i < len; i++)
+        {
+            crc ^= data[i];
+            for (uint8_t k = 0; k < 8; k++)
+                crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+        }
+        return ~crc;
+    }
 };
 
 namespace MemoryHelper
@@ -751,7 +765,7 @@ namespace Base64Helper
 
     inline size_t encodedLength(size_t len)
     {
-        return ((len + 2) / 3 * 4) + 1;
+        return Base64Codec::encodedLength(len, true) + 1;
     }
 
     inline int decodedLen(const char *src)
@@ -766,283 +780,65 @@ namespace Base64Helper
         return (3 * (len / 4)) - pad;
     }
 
-    inline unsigned char *creatBase64EncBuffer(MB_FS *mbfs, bool isURL)
-    {
-        unsigned char *base64EncBuf = MemoryHelper::createBuffer<unsigned char *>(mbfs, 65);
-        strcpy_P((char *)base64EncBuf, (char *)esp_signer_base64_table);
-        if (isURL)
-        {
-            base64EncBuf[62] = '-';
-            base64EncBuf[63] = '_';
-        }
-        return base64EncBuf;
-    }
-
-    inline unsigned char *creatBase64DecBuffer(MB_FS *mbfs)
-    {
-        unsigned char *base64DecBuf = MemoryHelper::createBuffer<unsigned char *>(mbfs, 256, false);
-        memset(base64DecBuf, 0x80, 256);
-        for (size_t i = 0; i < sizeof(esp_signer_base64_table) - 1; i++)
-            base64DecBuf[esp_signer_base64_table[i]] = (unsigned char)i;
-        base64DecBuf['='] = 0;
-        return base64DecBuf;
-    }
-
-    template <typename T = uint8_t>
-    inline bool writeOutput(MB_FS *mbfs, esp_signer_base64_io_t<T> &out)
-    {
-        size_t write = out.bufWrite;
-        out.bufWrite = 0;
-
-        if (out.outC && out.outC->write((uint8_t *)out.outT, write) == write)
-            return true;
-        else if (out.filetype != mb_fs_mem_storage_type_undefined && mbfs->write(mbfs_type out.filetype,
-                                                                                 (uint8_t *)out.outT, write) == (int)write)
-            return true;
-        return false;
-    }
-
-    template <typename T = uint8_t>
-    inline bool setOutput(MB_FS *mbfs, uint8_t val, esp_signer_base64_io_t<T> &out, T **pos)
-    {
-        if (out.outT)
-        {
-            if (out.outC || out.filetype != mb_fs_mem_storage_type_undefined)
-            {
-                out.outT[out.bufWrite++] = val;
-                if (out.bufWrite == (int)out.bufLen && !writeOutput(mbfs, out))
-                    return false;
-            }
-            else
-                *(*pos)++ = (T)(val);
-        }
-        else if (out.outL)
-            out.outL->push_back(val);
-
-        return true;
-    }
-
-    template <typename T>
-    inline bool decode(MB_FS *mbfs, unsigned char *base64DecBuf, const char *src, size_t len, esp_signer_base64_io_t<T> &out)
-    {
-        // the maximum chunk size that writes to output is limited by out.bufLen, the minimum is depending on the source length
-        bool ret = false;
-        unsigned char *block = MemoryHelper::createBuffer<unsigned char *>(mbfs, 4, false);
-        unsigned char temp;
-        size_t i, count;
-        int pad = 0;
-        size_t extra_pad;
-        T *pos = out.outT ? (T *)&out.outT[0] : nullptr;
-        if (len == 0)
-            len = strlen(src);
-
-        count = 0;
-
-        for (i = 0; i < len; i++)
-        {
-            if ((uint8_t)base64DecBuf[(uint8_t)src[i]] != 0x80)
-                count++;
-        }
-
-        if (count == 0)
-            goto skip;
-
-        extra_pad = (4 - count % 4) % 4;
-        count = 0;
-        for (i = 0; i < len + extra_pad; i++)
-        {
-            unsigned char val;
-
-            if (i >= len)
-                val = '=';
-            else
-                val = src[i];
-
-            temp = base64DecBuf[val];
-
-            if (temp == 0x80)
-                continue;
-
-            if (val == '=')
-                pad++;
-
-            block[count] = temp;
-            count++;
-            if (count == 4)
-            {
-
-                setOutput(mbfs, (block[0] << 2) | (block[1] >> 4), out, &pos);
-
-                count = 0;
-                if (pad)
-                {
-                    if (pad == 1)
-                        setOutput(mbfs, (block[1] << 4) | (block[2] >> 2), out, &pos);
-                    else if (pad > 2)
-                        goto skip;
-
-                    break;
-                }
-                else
-                {
-                    setOutput(mbfs, (block[1] << 4) | (block[2] >> 2), out, &pos);
-                    setOutput(mbfs, (block[2] << 6) | block[3], out, &pos);
-                }
-            }
-        }
-
-        // write remaining
-        if (out.bufWrite > 0 && !writeOutput(mbfs, out))
-            goto skip;
-
-        ret = true;
-
-    skip:
-        MemoryHelper::freeBuffer(mbfs, block);
-        return ret;
-    }
-
-    template <typename T>
-    inline bool encodeLast(MB_FS *mbfs, unsigned char *base64EncBuf, const unsigned char *in, size_t len,
-                           esp_signer_base64_io_t<T> &out, T **pos)
-    {
-        if (len > 2)
-            return false;
-
-        if (!setOutput(mbfs, base64EncBuf[in[0] >> 2], out, pos))
-            return false;
-
-        if (len == 1)
-        {
-            if (!setOutput(mbfs, base64EncBuf[(in[0] & 0x03) << 4], out, pos))
-                return false;
-            if (!setOutput(mbfs, '=', out, pos))
-                return false;
-        }
-        else
-        {
-            if (!setOutput(mbfs, base64EncBuf[((in[0] & 0x03) << 4) | (in[1] >> 4)], out, pos))
-                return false;
-            if (!setOutput(mbfs, base64EncBuf[(in[1] & 0x0f) << 2], out, pos))
-                return false;
-        }
-
-        if (!setOutput(mbfs, '=', out, pos))
-            return false;
-
-        return true;
-    }
-
-    template <typename T>
-    inline bool encode(MB_FS *mbfs, unsigned char *base64EncBuf, uint8_t *src, size_t len,
-                       esp_signer_base64_io_t<T> &out, bool writeAllRemaining = true)
-    {
-        const unsigned char *end, *in;
-
-        T *pos = out.outT ? (T *)&out.outT[0] : nullptr;
-        in = src;
-        end = src + len;
-
-        while (end - in >= 3)
-        {
-            if (!setOutput(mbfs, base64EncBuf[in[0] >> 2], out, &pos))
-                return false;
-            if (!setOutput(mbfs, base64EncBuf[((in[0] & 0x03) << 4) | (in[1] >> 4)], out, &pos))
-                return false;
-            if (!setOutput(mbfs, base64EncBuf[((in[1] & 0x0f) << 2) | (in[2] >> 6)], out, &pos))
-                return false;
-            if (!setOutput(mbfs, base64EncBuf[in[2] & 0x3f], out, &pos))
-                return false;
-            in += 3;
-        }
-
-        if (end - in && !encodeLast(mbfs, base64EncBuf, in, end - in, out, &pos))
-            return false;
-
-        if (writeAllRemaining && out.bufWrite > 0 && !writeOutput(mbfs, out))
-            return false;
-
-        return true;
-    }
     template <typename T>
     inline bool decodeToArray(MB_FS *mbfs, const MB_String &src, MB_VECTOR<T> &val)
     {
-        esp_signer_base64_io_t<T> out;
-        out.outL = &val;
-        unsigned char *base64DecBuf = creatBase64DecBuffer(mbfs);
-        bool ret = decode<T>(mbfs, base64DecBuf, src.c_str(), src.length(), out);
-        MemoryHelper::freeBuffer(mbfs, base64DecBuf);
-        return ret;
+        Base64Codec::VectorSink<T> sink(&val);
+        Base64Codec::Decoder decoder(&sink);
+        decoder.push(src.c_str(), src.length());
+        return decoder.end();
     }
 
     inline bool decodeToFile(MB_FS *mbfs, const char *src, size_t len, mbfs_file_type type)
     {
-        esp_signer_base64_io_t<uint8_t> out;
-        out.filetype = type;
-        uint8_t *buf = MemoryHelper::createBuffer<uint8_t *>(mbfs, out.bufLen);
-        out.outT = buf;
-        unsigned char *base64DecBuf = creatBase64DecBuffer(mbfs);
-        bool ret = decode<uint8_t>(mbfs, base64DecBuf, src, strlen(src), out);
-        MemoryHelper::freeBuffer(mbfs, buf);
-        MemoryHelper::freeBuffer(mbfs, base64DecBuf);
-        return ret;
+        Base64Codec::FileSink sink(mbfs, type);
+        Base64Codec::Decoder decoder(&sink);
+        decoder.push(src, len > 0 ? len : strlen(src));
+        return decoder.end();
     }
 
     inline void encodeUrl(MB_FS *mbfs, char *encoded, unsigned char *string, size_t len)
     {
-        size_t i;
-        char *p = encoded;
-        unsigned char *base64EncBuf = creatBase64EncBuffer(mbfs, true);
-
-        for (i = 0; i < len - 2; i += 3)
-        {
-            *p++ = base64EncBuf[(string[i] >> 2) & 0x3F];
-            *p++ = base64EncBuf[((string[i] & 0x3) << 4) | ((int)(string[i + 1] & 0xF0) >> 4)];
-            *p++ = base64EncBuf[((string[i + 1] & 0xF) << 2) | ((int)(string[i + 2] & 0xC0) >> 6)];
-            *p++ = base64EncBuf[string[i + 2] & 0x3F];
-        }
-
-        if (i < len)
-        {
-            *p++ = base64EncBuf[(string[i] >> 2) & 0x3F];
-            if (i == (len - 1))
-                *p++ = base64EncBuf[((string[i] & 0x3) << 4)];
-            else
-            {
-                *p++ = base64EncBuf[((string[i] & 0x3) << 4) | ((int)(string[i + 1] & 0xF0) >> 4)];
-                *p++ = base64EncBuf[((string[i + 1] & 0xF) << 2)];
-            }
-        }
-
-        *p++ = '\0';
-
-        MemoryHelper::freeBuffer(mbfs, base64EncBuf);
+        // unpadded
+        encoded[Base64Codec::encode(encoded, string, len, true, false)] = '\0';
     }
 
     inline MB_String encodeToString(MB_FS *mbfs, uint8_t *src, size_t len)
     {
         MB_String str;
-        char *encoded = MemoryHelper::createBuffer<char *>(mbfs, encodedLength(len) + 1);
-        esp_signer_base64_io_t<char> out;
-        out.outT = encoded;
-        unsigned char *base64EncBuf = creatBase64EncBuffer(mbfs, false);
-        if (encode<char>(mbfs, base64EncBuf, (uint8_t *)src, len, out))
+        char *encoded = MemoryHelper::createBuffer<char *>(mbfs, encodedLength(len));
+        if (encoded)
+        {
+            encoded[Base64Codec::encode(encoded, src, len)] = '\0';
             str = encoded;
-        MemoryHelper::freeBuffer(mbfs, encoded);
-        MemoryHelper::freeBuffer(mbfs, base64EncBuf);
+            MemoryHelper::freeBuffer(mbfs, encoded);
+        }
         return str;
     }
 
     inline bool encodeToClient(Client *client, MB_FS *mbfs, size_t bufSize, uint8_t *data, size_t len)
     {
-        esp_signer_base64_io_t<uint8_t> out;
-        out.outC = client;
-        uint8_t *buf = MemoryHelper::createBuffer<uint8_t *>(mbfs, out.bufLen);
-        out.outT = buf;
-        unsigned char *base64EncBuf = creatBase64EncBuffer(mbfs, false);
-        bool ret = encode<uint8_t>(mbfs, base64EncBuf, (uint8_t *)data, len, out);
+        if (bufSize < 4)
+            bufSize = 1024;
+
+        char *buf = MemoryHelper::createBuffer<char *>(mbfs, bufSize);
+        if (!buf)
+            return false;
+
+        // the whole 3 bytes groups per chunk, only the last chunk is padded
+        size_t chunk = bufSize / 4 * 3;
+        bool ret = true;
+
+        while (ret && len > 0)
+        {
+            size_t n = len < chunk ? len : chunk;
+            size_t write = Base64Codec::encode(buf, data, n);
+            ret = client->write((uint8_t *)buf, write) == write;
+            data += n;
+            len -= n;
+        }
+
         MemoryHelper::freeBuffer(mbfs, buf);
-        MemoryHelper::freeBuffer(mbfs, base64EncBuf);
         return ret;
     }
 };
@@ -1151,58 +947,6 @@ namespace HttpHelper
         header += esp_signer_pgm_str_18; // "Bearer "
     }
 
-    inline void parseRespHeader(const MB_String &src, struct esp_signer_server_response_data_t &response)
-    {
-        int beginPos = 0;
-
-        MB_String out;
-
-        if (response.httpCode != -1)
-        {
-
-            StringHelper::tokenSubString(src, response.connection,
-                                         esp_signer_pgm_str_20 /* "Connection: " */,
-                                         esp_signer_pgm_str_1 /* "\r\n" */, beginPos, 0, false);
-            StringHelper::tokenSubString(src, response.contentType,
-                                         esp_signer_pgm_str_21 /* "Content-Type: " */,
-                                         esp_signer_pgm_str_1 /* "\r\n" */, beginPos, 0, false);
-            StringHelper::tokenSubStringInt(src, response.contentLen,
-                                            esp_signer_pgm_str_22 /* "Content-Length: " */,
-                                            esp_signer_pgm_str_1 /* "\r\n" */, beginPos, 0, false);
-            StringHelper::tokenSubString(src, response.etag,
-                                         esp_signer_pgm_str_23 /* "ETag: " */,
-                                         esp_signer_pgm_str_1 /* "\r\n" */, beginPos, 0, false);
-            response.payloadLen = response.contentLen;
-
-            if (StringHelper::tokenSubString(src, response.transferEnc,
-                                             esp_signer_pgm_str_24 /* "Transfer-Encoding: " */,
-                                             esp_signer_pgm_str_1 /* "\r\n" */, beginPos, 0, false) &&
-                StringHelper::compare(response.transferEnc, 0, esp_signer_pgm_str_25 /* "chunked" */))
-                response.isChunkedEnc = true;
-
-            if (response.httpCode == ESP_SIGNER_ERROR_HTTP_CODE_OK ||
-                response.httpCode == ESP_SIGNER_ERROR_HTTP_CODE_TEMPORARY_REDIRECT ||
-                response.httpCode == ESP_SIGNER_ERROR_HTTP_CODE_PERMANENT_REDIRECT ||
-                response.httpCode == ESP_SIGNER_ERROR_HTTP_CODE_MOVED_PERMANENTLY ||
-                response.httpCode == ESP_SIGNER_ERROR_HTTP_CODE_FOUND)
-                StringHelper::tokenSubString(src, response.location,
-                                             esp_signer_pgm_str_26 /* "Location: " */,
-                                             esp_signer_pgm_str_1 /* "\r\n" */, beginPos, 0, false);
-
-            if (response.httpCode == ESP_SIGNER_ERROR_HTTP_CODE_NO_CONTENT)
-                response.noContent = true;
-        }
-    }
-
-    inline int getStatusCode(const MB_String &header, int &pos)
-    {
-        int code = 0;
-        StringHelper::tokenSubStringInt(header, code,
-                                        esp_signer_pgm_str_27 /* "HTTP/1.1 " */,
-                                        esp_signer_pgm_str_15 /* " " */, pos, 0, false);
-        return code;
-    }
-
     inline void getCustomHeaders(MB_String &header, const MB_String &tokens)
     {
         if (tokens.length() > 0)
@@ -1226,274 +970,6 @@ namespace HttpHelper
         }
     }
 
-    inline void intTCPHandler(GAuth_TCP_Client *client, struct esp_signer_tcp_response_handler_t &tcpHandler,
-                              size_t defaultChunkSize, size_t respSize, MB_String *payload)
-    {
-        // set the client before calling available
-        tcpHandler.client = (Client *)client;
-        tcpHandler.payloadLen = 0;
-        tcpHandler.payloadRead = 0;
-        tcpHandler.chunkBufSize = tcpHandler.available(); // client must be set before calling
-        tcpHandler.defaultChunkSize = respSize;
-        tcpHandler.error.code = -1;
-        tcpHandler.defaultChunkSize = defaultChunkSize;
-        tcpHandler.bufferAvailable = 0;
-        tcpHandler.header.clear();
-        tcpHandler.dataTime = millis();
-        tcpHandler.payload = payload;
-    }
-
-    inline int readLine(Client *client, char *buf, int bufLen)
-    {
-        if (!client)
-            return 0;
-
-        int res = -1;
-        char c = 0;
-        int idx = 0;
-        if (!client)
-            return idx;
-        while (client->available() && idx < bufLen)
-        {
-            if (!client)
-                break;
-
-            Utils::idle();
-
-            res = client->read();
-            if (res > -1)
-            {
-                c = (char)res;
-                buf[idx++] = c;
-                if (c == '\n')
-                    return idx;
-            }
-        }
-        return idx;
-    }
-
-    inline int readLine(Client *client, MB_String &buf)
-    {
-        if (!client)
-            return 0;
-
-        int res = -1;
-        char c = 0;
-        int idx = 0;
-        if (!client)
-            return idx;
-        while (client->available())
-        {
-            if (!client)
-                break;
-
-            Utils::idle();
-
-            res = client->read();
-            if (res > -1)
-            {
-                c = (char)res;
-                buf += c;
-                idx++;
-                if (c == '\n')
-                    return idx;
-            }
-        }
-        return idx;
-    }
-
-    inline uint32_t hex2int(const char *hex)
-    {
-        uint32_t val = 0;
-        while (*hex)
-        {
-            // get current character then increment
-            uint8_t byte = *hex++;
-            // transform hex character to the 4bit equivalent number, using the ascii table indexes
-            if (byte >= '0' && byte <= '9')
-                byte = byte - '0';
-            else if (byte >= 'a' && byte <= 'f')
-                byte = byte - 'a' + 10;
-            else if (byte >= 'A' && byte <= 'F')
-                byte = byte - 'A' + 10;
-            // shift 4 to make space for new digit, and add the 4 bits of the new digit
-            val = (val << 4) | (byte & 0xF);
-        }
-        return val;
-    }
-
-    // Returns -1 when complete
-    inline int readChunkedData(MB_FS *mbfs, Client *client, char *out1, MB_String *out2,
-                               struct esp_signer_tcp_response_handler_t &tcpHandler)
-    {
-        if (!client)
-            return 0;
-
-        int bufLen = tcpHandler.chunkBufSize;
-        char *buf = nullptr;
-        int p1 = 0;
-        int olen = 0;
-
-        if (tcpHandler.chunkState.state == 0)
-        {
-            tcpHandler.chunkState.state = 1;
-            tcpHandler.chunkState.chunkedSize = -1;
-            tcpHandler.chunkState.dataLen = 0;
-
-            MB_String s;
-            int readLen = 0;
-
-            if (out2)
-                readLen = readLine(client, s);
-            else if (out1)
-            {
-                buf = MemoryHelper::createBuffer<char *>(mbfs, bufLen);
-                readLen = readLine(client, buf, bufLen);
-            }
-
-            if (readLen)
-            {
-                if (out1)
-                    s = buf;
-
-                p1 = StringHelper::strpos(s.c_str(), (const char *)MBSTRING_FLASH_MCR(";"), 0);
-                if (p1 == -1)
-                    p1 = StringHelper::strpos(s.c_str(), (const char *)MBSTRING_FLASH_MCR("\r\n"), 0);
-
-                if (p1 != -1)
-                {
-                    if (out2)
-                        tcpHandler.chunkState.chunkedSize = hex2int(s.substr(0, p1).c_str());
-                    else if (out1)
-                    {
-                        char *temp = MemoryHelper::createBuffer<char *>(mbfs, p1 + 1);
-                        memcpy(temp, buf, p1);
-                        tcpHandler.chunkState.chunkedSize = hex2int(temp);
-                        MemoryHelper::freeBuffer(mbfs, temp);
-                    }
-                }
-
-                // last chunk
-                if (tcpHandler.chunkState.chunkedSize < 1)
-                    olen = -1;
-            }
-            else
-                tcpHandler.chunkState.state = 0;
-
-            if (out1)
-                MemoryHelper::freeBuffer(mbfs, buf);
-        }
-        else
-        {
-            if (tcpHandler.chunkState.chunkedSize > -1)
-            {
-                MB_String s;
-                int readLen = 0;
-
-                if (out2)
-                    readLen = readLine(client, s);
-                else if (out1)
-                {
-                    buf = MemoryHelper::createBuffer<char *>(mbfs, bufLen);
-                    readLen = readLine(client, buf, bufLen);
-                }
-
-                if (readLen > 0)
-                {
-                    // chunk may contain trailing
-                    if (tcpHandler.chunkState.dataLen + readLen - 2 < tcpHandler.chunkState.chunkedSize)
-                    {
-                        tcpHandler.chunkState.dataLen += readLen;
-                        if (out2)
-                            *out2 += s;
-                        else if (out1)
-                            memcpy(out1, buf, readLen);
-
-                        olen = readLen;
-                    }
-                    else
-                    {
-                        if (tcpHandler.chunkState.chunkedSize - tcpHandler.chunkState.dataLen > 0)
-                        {
-                            if (out2)
-                                *out2 += s;
-                            else if (out1)
-                                memcpy(out1, buf, tcpHandler.chunkState.chunkedSize - tcpHandler.chunkState.dataLen);
-                        }
-
-                        tcpHandler.chunkState.dataLen = tcpHandler.chunkState.chunkedSize;
-                        tcpHandler.chunkState.state = 0;
-                        olen = readLen;
-                    }
-                }
-                // if all chunks read, returns -1
-                else if (tcpHandler.chunkState.dataLen == tcpHandler.chunkState.chunkedSize)
-                    olen = -1;
-
-                if (out1)
-                    MemoryHelper::freeBuffer(mbfs, buf);
-            }
-        }
-
-        return olen;
-    }
-
-    inline bool readStatusLine(MB_FS *mbfs, Client *client, struct esp_signer_tcp_response_handler_t &tcpHandler,
-                               struct esp_signer_server_response_data_t &response)
-    {
-        tcpHandler.chunkIdx++;
-
-        if (!tcpHandler.isHeader && tcpHandler.chunkIdx > 1)
-            tcpHandler.pChunkIdx++;
-
-        if (tcpHandler.chunkIdx > 1)
-            return false;
-
-        // the first chunk (line) can be http response status or already connected stream payload
-        char *hChunk = MemoryHelper::createBuffer<char *>(mbfs, tcpHandler.chunkBufSize);
-        int readLen = readLine(client, hChunk, tcpHandler.chunkBufSize);
-        if (readLen > 0)
-            tcpHandler.header += hChunk;
-
-        int pos = 0;
-        int status = HttpHelper::getStatusCode(hChunk, pos);
-        if (status > 0)
-        {
-            // http response status
-            tcpHandler.isHeader = true;
-            response.httpCode = status;
-        }
-
-        MemoryHelper::freeBuffer(mbfs, hChunk);
-        return true;
-    }
-
-    inline bool readHeader(MB_FS *mbfs, Client *client, struct esp_signer_tcp_response_handler_t &tcpHandler,
-                           struct esp_signer_server_response_data_t &response)
-    {
-        // do not check of the config here to allow legacy fcm to work
-
-        char *hChunk = MemoryHelper::createBuffer<char *>(mbfs, tcpHandler.chunkBufSize);
-        int readLen = readLine(client, hChunk, tcpHandler.chunkBufSize);
-
-        // check is it the end of http header (\n or \r\n)?
-        if ((readLen == 1 && hChunk[0] == '\r') || (readLen == 2 && hChunk[0] == '\r' && hChunk[1] == '\n'))
-            tcpHandler.headerEnded = true;
-
-        if (tcpHandler.headerEnded)
-        {
-            // parse header string to get the header field
-            tcpHandler.isHeader = false;
-            HttpHelper::parseRespHeader(tcpHandler.header, response);
-        }
-        // accumulate the remaining header field
-        else if (readLen > 0)
-            tcpHandler.header += hChunk;
-
-        MemoryHelper::freeBuffer(mbfs, hChunk);
-        return tcpHandler.headerEnded;
-    }
-
 };
 
 namespace Utils
@@ -0,0 +1,156 @@
+/**
+ * GAuth JWT Template v1.0.0
+ *
+ * This library supports Espressif ESP8266, ESP32 and Raspberry Pi Pico MCUs.
+ *
+ * The MIT License (MIT)
+ * Copyright (c) 2022 K. Suwatchai (Mobizt)
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person returning a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef GAUTH_JWT_TEMPLATE_H
+#define GAUTH_JWT_TEMPLATE_H
+
+#include <Arduino.h>
+#include "mbfs/MB_MCU.h"
+#include "mbfs/MB_FS.h"
+#include "ESP_Signer_Const.h"
+#include "ESP_Signer_Helper.h"
+#include "GAuth_JWT_Writer.h"
+
+/* Keeps the encoded JWT header and payload (without signature) of the last token request.
+ * Between the refreshes, only the "iat" and "exp" claims change. The next JWT is created
+ * from the template by rewriting the Base64 characters of the timestamps, the SHA-256 digest
+ * continues from the state before the timestamps that was kept.
+ */
+class GAuth_JWT_Template
+{
+public:
+    GAuth_JWT_Template(){};
+    ~GAuth_JWT_Template() { clear(); }
+
+    void begin(MB_FS *mbfs) { this->mbfs = mbfs; }
+
+    /* the identity of the claims and key that the template was created from */
+    static uint64_t identity(const char *email, const char *audience, const char *scope, uint64_t keyId)
+    {
+        uint64_t h = 0xcbf29ce484222325ULL ^ keyId;
+        h = hash(h, email);
+        // the assertion (no audience) and the self-signed JWT without audience are different
+        h = hash(h, audience ? audience : "\x01");
+        return hash(h, scope);
+    }
+
+    bool matches(uint64_t id) const { return buf && this->id == id; }
+
+    /* copy the JWT which was written by the writer, the timestamps should be fixed width */
+    bool compile(const GAuth_JWT_Writer &writer, uint64_t id)
+    {
+        if (!mbfs || writer.timestampsLength() == 0)
+        {
+            clear();
+            return false;
+        }
+
+        size_t n = writer.length();
+
+        if (!buf || cap < n + 1)
+        {
+            clear();
+            buf = MemoryHelper::createBuffer<char *>(mbfs, n + 1, false);
+            if (!buf)
+                return false;
+            cap = n + 1;
+        }
+
+        memcpy(buf, writer.c_str(), n);
+        buf[n] = '\0';
+        len = n;
+        offset = writer.timestampsOffset();
+        length = writer.timestampsLength();
+        state = writer.timestampsState();
+        expKey = writer.timestampsExpKey();
+        this->id = id;
+        return true;
+    }
+
+    /* write the JWT from the template with the new timestamps and create its digest,
+     * the extra is the room for the signature
+     */
+    bool stamp(GAuth_JWT_Writer &writer, uint32_t iat, uint32_t exp, size_t extra)
+    {
+        if (!buf || iat < 1000000000 || exp < 1000000000)
+            return false;
+
+        if (!writer.reserve(len + extra))
+            return false;
+
+        writer.resume(buf, offset, state);
+        writer.encodeTimestampValues(iat, expKey, exp);
+
+        if (writer.length() != offset + length)
+            return false;
+
+        writer.write(buf + offset + length, len - offset - length);
+        writer.digest();
+        return true;
+    }
+
+    void clear()
+    {
+        if (buf)
+        {
+            memset(buf, 0, cap);
+            MemoryHelper::freeBuffer(mbfs, buf);
+        }
+        buf = nullptr;
+        cap = 0;
+        len = 0;
+        offset = 0;
+        length = 0;
+        id = 0;
+    }
+
+private:
+    MB_FS *mbfs = nullptr;
+    char *buf = nullptr;
+    size_t cap = 0;
+    size_t len = 0;
+    size_t offset = 0;
+    size_t length = 0;
+    br_sha256_context state;
+    PGM_P expKey = nullptr;
+    uint64_t id = 0;
+
+    // FNV-1a, with the separator after the string
+    static uint64_t hash(uint64_t h, const char *s)
+    {
+        while (s && *s)
+        {
+            h ^= (uint8_t)*s++;
+            h *= 0x100000001b3ULL;
+        }
+        h ^= 0xff;
+        h *= 0x100000001b3ULL;
+        return h;
+    }
+};
+
+#endif
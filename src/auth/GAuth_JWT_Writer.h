@@ -0,0 +1,391 @@
+/**
+ * GAuth JWT Writer v1.0.0
+ *
+ * This library supports Espressif ESP8266, ESP32 and Raspberry Pi Pico MCUs.
+ *
+ * The MIT License (MIT)
+ * Copyright (c) 2022 K. Suwatchai (Mobizt)
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person returning a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef GAUTH_JWT_WRITER_H
+#define GAUTH_JWT_WRITER_H
+
+#include <Arduino.h>
+#include "mbfs/MB_MCU.h"
+#include "mbfs/MB_FS.h"
+#include "ESP_Signer_Const.h"
+#include "ESP_Signer_Helper.h"
+#include "ESP_Signer_Base64.h"
+#include "client/SSLClient/ESP_SSLClient.h"
+
+/* Writes the JWT (<header>.<payload>.<signature>) into one buffer.
+ * The JSON claims are Base64URL encoded while they are written, no JSON object or
+ * intermediate string is created.
+ *
+ * The same write sequence runs twice, first after measure() to count the output length,
+ * then after reserve() to write the data.
+ *
+ * The SHA-256 digest of the written data is updated while writing, the state after the
+ * constant header is computed once and reused.
+ *
+ * The "iat" and "exp" claims are written with encodeTimestamps() to make the JWT reusable
+ * as the template.
+ */
+class GAuth_JWT_Writer
+{
+public:
+    GAuth_JWT_Writer(){};
+    ~GAuth_JWT_Writer() { clear(); }
+
+    void begin(MB_FS *mbfs) { this->mbfs = mbfs; }
+
+    /* start the counting pass */
+    void measure()
+    {
+        measuring = true;
+        len = 0;
+        carryLen = 0;
+        tsOffset = 0;
+        tsLength = 0;
+    }
+
+    /* start the writing pass, the buffer is reused when it is large enough */
+    bool reserve(size_t size)
+    {
+        if (!mbfs)
+            return false;
+
+        if (!buf || cap < size + 1)
+        {
+            clear();
+            buf = MemoryHelper::createBuffer<char *>(mbfs, size + 1, false);
+            if (!buf)
+                return false;
+            cap = size + 1;
+        }
+
+        measuring = false;
+        len = 0;
+        carryLen = 0;
+        tsOffset = 0;
+        tsLength = 0;
+        buf[0] = '\0';
+        hashing = true;
+        br_sha256_init(&mc);
+        return true;
+    }
+
+    /* append the text as is */
+    void write(const char *s, size_t n)
+    {
+        if (!measuring && len + n < cap)
+        {
+            memcpy(buf + len, s, n);
+            buf[len + n] = '\0';
+            update(n);
+        }
+        len += n;
+    }
+
+    void write(char c) { write(&c, 1); }
+
+    /* append the PROGMEM text as is */
+    void writeP(PGM_P s)
+    {
+        size_t n = strlen_P(s);
+        if (!measuring && len + n < cap)
+        {
+            memcpy_P(buf + len, s, n);
+            buf[len + n] = '\0';
+            update(n);
+        }
+        len += n;
+    }
+
+    /* append the encoded JWT header and ".", this should be the first write,
+     * the digest continues from the SHA-256 state that was kept for this header
+     */
+    void writeHeader(PGM_P header)
+    {
+        if (!measuring && header != midstateHeader)
+        {
+            // the header is shorter than one SHA-256 block, the state keeps it as the pending data
+            br_sha256_init(&midstate);
+            char chunk[32];
+            size_t n = strlen_P(header);
+            for (size_t i = 0; i < n; i += sizeof(chunk))
+            {
+                size_t m = n - i < sizeof(chunk) ? n - i : sizeof(chunk);
+                memcpy_P(chunk, header + i, m);
+                br_sha256_update(&midstate, chunk, m);
+            }
+            br_sha256_update(&midstate, ".", 1);
+            midstateHeader = header;
+        }
+
+        hashing = false;
+        writeP(header);
+        write('.');
+
+        if (!measuring)
+        {
+            mc = midstate;
+            hashing = true;
+        }
+    }
+
+    /* append the data that was already added to the SHA-256 state, the digest continues from the state */
+    void resume(const char *data, size_t n, const br_sha256_context &state)
+    {
+        hashing = false;
+        write(data, n);
+
+        if (!measuring)
+        {
+            mc = state;
+            hashing = true;
+        }
+    }
+
+    /* Base64URL encode (without padding) the data while appending,
+     * the whole 3 bytes groups are encoded directly into the buffer
+     */
+    void encode(const uint8_t *data, size_t n)
+    {
+        while (carryLen > 0 && n > 0)
+        {
+            carry[carryLen++] = *data++;
+            n--;
+            if (carryLen == 3)
+                flushCarry();
+        }
+
+        size_t whole = n - n % 3;
+        if (whole > 0)
+        {
+            size_t chars = whole / 3 * 4;
+            if (!measuring && len + chars < cap)
+            {
+                Base64Codec::encode(buf + len, data, whole, true, false);
+                buf[len + chars] = '\0';
+                update(chars);
+            }
+            len += chars;
+            data += whole;
+            n -= whole;
+        }
+
+        while (n > 0)
+        {
+            carry[carryLen++] = *data++;
+            n--;
+        }
+    }
+
+    void encode(const char *s) { encode((const uint8_t *)s, strlen(s)); }
+
+    void encode(char c) { encode((const uint8_t *)&c, 1); }
+
+    void encodeP(PGM_P s)
+    {
+        size_t n = strlen_P(s);
+        for (size_t i = 0; i < n; i++)
+        {
+            uint8_t c = pgm_read_byte(s + i);
+            encode(&c, 1);
+        }
+    }
+
+    /* write the remaining 1 or 2 bytes of the encoded data */
+    void encodeEnd()
+    {
+        if (carryLen > 0)
+            flushCarry();
+    }
+
+    /* encode the JSON string content (escaped, without quotes) */
+    void encodeEscaped(const char *s, size_t n)
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            uint8_t c = s[i];
+            if (c == '"' || c == '\\')
+            {
+                uint8_t esc[2] = {'\\', c};
+                encode(esc, 2);
+            }
+            else if (c < 0x20)
+            {
+                char esc[7];
+                snprintf(esc, sizeof(esc), "\\u%04x", c);
+                encode((const uint8_t *)esc, 6);
+            }
+            else
+                encode(&c, 1);
+        }
+    }
+
+    /* encode the JSON string value (quoted and escaped) */
+    void encodeString(const char *s, size_t n)
+    {
+        encode('"');
+        encodeEscaped(s, n);
+        encode('"');
+    }
+
+    /* encode the JSON member name e.g. "iss": */
+    void encodeKey(PGM_P key, bool first = false)
+    {
+        encode((const uint8_t *)(first ? "{\"" : ",\""), 2);
+        encodeP(key);
+        encode((const uint8_t *)"\":", 2);
+    }
+
+    void encodeClaim(PGM_P key, const char *value, bool first = false)
+    {
+        encodeKey(key, first);
+        encodeString(value, strlen(value));
+    }
+
+    void encodeClaim(PGM_P key, uint32_t value, bool first = false)
+    {
+        char num[11];
+        encodeKey(key, first);
+        encode((const uint8_t *)num, snprintf(num, sizeof(num), "%u", (unsigned int)value));
+    }
+
+    /* encode the "iat" and "exp" claims, the "iat" value starts at the Base64 group boundary.
+     * When both values are 10 digits (Sep 2001 to Nov 2286), the values are encoded into the
+     * same number of characters and can be rewritten in place, see GAuth_JWT_Template.
+     */
+    void encodeTimestamps(PGM_P iatKey, uint32_t iat, PGM_P expKey, uint32_t exp)
+    {
+        encodeKey(iatKey);
+
+        // the JSON white space before the value moves it to the group boundary
+        while (carryLen > 0)
+            encode(' ');
+
+        size_t offset = len;
+        if (!measuring)
+            tsState = mc;
+
+        encodeTimestampValues(iat, expKey, exp);
+
+        tsOffset = 0;
+        tsLength = 0;
+
+        if (carryLen == 0 && iat >= 1000000000 && exp >= 1000000000)
+        {
+            tsOffset = offset;
+            tsLength = len - offset;
+            tsExpKey = expKey;
+        }
+    }
+
+    /* encode the "iat" value and the "exp" claim */
+    void encodeTimestampValues(uint32_t iat, PGM_P expKey, uint32_t exp)
+    {
+        char num[11];
+        encode((const uint8_t *)num, snprintf(num, sizeof(num), "%u", (unsigned int)iat));
+        encodeKey(expKey);
+        encode((const uint8_t *)num, snprintf(num, sizeof(num), "%u", (unsigned int)exp));
+    }
+
+    /* the position and length of the encoded timestamps from encodeTimestamps(), the length is 0 when they are not fixed width */
+    size_t timestampsOffset() const { return tsOffset; }
+
+    size_t timestampsLength() const { return tsLength; }
+
+    /* the SHA-256 state of the content before the encoded timestamps */
+    const br_sha256_context &timestampsState() const { return tsState; }
+
+    PGM_P timestampsExpKey() const { return tsExpKey; }
+
+    /* create the SHA-256 message digest of the current content, the later writes are not included */
+    void digest()
+    {
+        br_sha256_out(&mc, hash);
+        hashing = false;
+    }
+
+    /* the message digest from digest() */
+    const uint8_t *getHash() const { return hash; }
+
+    /* the Base64URL (unpadded) length of n bytes */
+    static size_t encodedLength(size_t n) { return Base64Codec::encodedLength(n, false); }
+
+    size_t length() const { return len; }
+
+    const char *c_str() const { return buf && !measuring ? buf : ""; }
+
+    void clear()
+    {
+        if (buf)
+        {
+            memset(buf, 0, cap);
+            MemoryHelper::freeBuffer(mbfs, buf);
+        }
+        buf = nullptr;
+        cap = 0;
+        len = 0;
+        carryLen = 0;
+        memset(hash, 0, sizeof(hash));
+        hashing = false;
+        tsOffset = 0;
+        tsLength = 0;
+    }
+
+private:
+    MB_FS *mbfs = nullptr;
+    char *buf = nullptr;
+    size_t cap = 0;
+    size_t len = 0;
+    bool measuring = false;
+    uint8_t carry[3];
+    uint8_t carryLen = 0;
+    uint8_t hash[br_sha256_SIZE];
+    bool hashing = false;
+    br_sha256_context mc;
+    br_sha256_context midstate;
+    PGM_P midstateHeader = nullptr;
+    size_t tsOffset = 0;
+    size_t tsLength = 0;
+    br_sha256_context tsState;
+    PGM_P tsExpKey = nullptr;
+
+    // add the last n bytes written to the digest
+    void update(size_t n)
+    {
+        if (hashing)
+            br_sha256_update(&mc, buf + len, n);
+    }
+
+    void flushCarry()
+    {
+        char out[4];
+        // unpadded, 1 byte -> 2 chars, 2 bytes -> 3 chars, 3 bytes -> 4 chars
+        write(out, Base64Codec::encode(out, carry, carryLen, true, false));
+        carryLen = 0;
+    }
+};
+
+#endif
@@ -0,0 +1,373 @@
+/**
+ * GAuth Key Cache v1.0.0
+ *
+ * This library supports Espressif ESP8266, ESP32 and Raspberry Pi Pico MCUs.
+ *
+ * The MIT License (MIT)
+ * Copyright (c) 2022 K. Suwatchai (Mobizt)
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person returning a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef GAUTH_KEY_CACHE_H
+#define GAUTH_KEY_CACHE_H
+
+#include <Arduino.h>
+#include "mbfs/MB_MCU.h"
+#include "mbfs/MB_FS.h"
+#include "ESP_Signer_Const.h"
+#include "ESP_Signer_Helper.h"
+#include "client/SSLClient/ESP_SSLClient.h"
+#include "GAuth_RSA_Key.h"
+
+/* Holds the decoded service account private key between token refreshes.
+ * The RSA and EC (P-256) keys are supported.
+ * The key components are copied into one buffer which is wiped before it is released.
+ */
+class GAuth_Key_Cache
+{
+public:
+    GAuth_Key_Cache()
+    {
+        memset(&rsa, 0, sizeof(br_rsa_private_key));
+        memset(&ec, 0, sizeof(br_ec_private_key));
+    }
+    ~GAuth_Key_Cache()
+    {
+        clear();
+        endDecoder();
+    }
+
+    void begin(MB_FS *mbfs)
+    {
+        this->mbfs = mbfs;
+#if defined(USE_LIB_SSL_ENGINE)
+        prepared.begin(mbfs);
+#endif
+    }
+
+    /* parse the PEM or DER encoded private key and keep its decoded components */
+    bool load(const uint8_t *key, size_t len)
+    {
+        clear();
+
+        if (!mbfs || !key || len == 0)
+            return false;
+
+        PrivateKey *pk = new PrivateKey(key, len);
+        Utils::idle();
+
+        bool ret = false;
+
+        if (pk->isRSA())
+        {
+            const br_rsa_private_key *sk = pk->getRSA();
+
+            ret = store(sk);
+
+            // wipe the parser's copy too, PrivateKey frees it without clearing
+            memset(sk->p, 0, sk->plen);
+            memset(sk->q, 0, sk->qlen);
+            memset(sk->dp, 0, sk->dplen);
+            memset(sk->dq, 0, sk->dqlen);
+            memset(sk->iq, 0, sk->iqlen);
+        }
+        else if (pk->isEC())
+        {
+            const br_ec_private_key *sk = pk->getEC();
+            ret = store(sk);
+            memset(sk->x, 0, sk->xlen);
+        }
+
+        delete pk;
+
+        return ret;
+    }
+
+    bool load(const char *pem) { return pem ? load((const uint8_t *)pem, strlen_P(pem)) : false; }
+
+    /* start decoding the PEM encoded private key which is passed in parts with pushPEM() */
+    bool beginPEM()
+    {
+        clear();
+        endDecoder();
+
+        decoder = new esp_signer_key_decoder_t();
+        if (!decoder)
+            return false;
+
+        br_pem_decoder_init(&decoder->pem);
+        br_skey_decoder_init(&decoder->skey);
+        return true;
+    }
+
+    /* decode the part of PEM text, the DER data is decoded while it is produced */
+    void pushPEM(const char *pem, size_t len)
+    {
+        if (!decoder || decoder->error || decoder->ended)
+            return;
+
+        const unsigned char *p = (const unsigned char *)pem;
+        while (len > 0)
+        {
+            size_t n = br_pem_decoder_push(&decoder->pem, p, len);
+            p += n;
+            len -= n;
+
+            switch (br_pem_decoder_event(&decoder->pem))
+            {
+            case BR_PEM_BEGIN_OBJ:
+                br_pem_decoder_setdest(&decoder->pem, skeyPush, &decoder->skey);
+                break;
+            case BR_PEM_END_OBJ:
+                // only the first object
+                decoder->ended = true;
+                return;
+            case BR_PEM_ERROR:
+                decoder->error = true;
+                return;
+            default:
+                break;
+            }
+        }
+    }
+
+    /* finish decoding and keep the decoded key */
+    bool endPEM()
+    {
+        // the last line may not end with new line
+        pushPEM("\n", 1);
+
+        bool ret = false;
+
+        if (decoder && decoder->ended && br_skey_decoder_last_error(&decoder->skey) == 0)
+        {
+            if (br_skey_decoder_key_type(&decoder->skey) == BR_KEYTYPE_RSA)
+                ret = store(br_skey_decoder_get_rsa(&decoder->skey));
+            else if (br_skey_decoder_key_type(&decoder->skey) == BR_KEYTYPE_EC)
+                ret = store(br_skey_decoder_get_ec(&decoder->skey));
+        }
+
+        endDecoder();
+        return ret;
+    }
+
+    /* the callback for MB_JSON_Extractor to pass the PEM text */
+    static void pemCallback(void *arg, const char *data, size_t len) { reinterpret_cast<GAuth_Key_Cache *>(arg)->pushPEM(data, len); }
+
+    /* the decoded key is available */
+    bool ready() const { return buf != nullptr; }
+
+    bool isRSA() const { return ready() && rsa.n_bitlen > 0; }
+
+    const br_rsa_private_key *getRSA() const { return isRSA() ? &rsa : nullptr; }
+
+    /* the P-256 key, the other curves are not kept */
+    bool isEC() const { return ready() && ec.xlen > 0; }
+
+    const br_ec_private_key *getEC() const { return isEC() ? &ec : nullptr; }
+
+    /* the signature length, the RSA modulus length or 64 bytes of the ES256 signature (r || s) */
+    size_t signatureLength() const
+    {
+        if (isRSA())
+            return (rsa.n_bitlen + 7) >> 3;
+        return isEC() ? 64 : 0;
+    }
+
+    /* the RSA PKCS#1 v1.5 signing function of the selected engine,
+     * auto selects i62 when the 64-bit multiplication is supported, otherwise i31.
+     * The i62 engine falls back to i31 when it is not supported.
+     */
+    static br_rsa_pkcs1_sign getRSASigner(esp_signer_rsa_engine engine)
+    {
+        br_rsa_pkcs1_sign sign = nullptr;
+
+        if (engine == esp_signer_rsa_engine_i15)
+            sign = &br_rsa_i15_pkcs1_sign;
+        else if (engine == esp_signer_rsa_engine_i31)
+            sign = &br_rsa_i31_pkcs1_sign;
+        else
+            sign = br_rsa_i62_pkcs1_sign_get();
+
+        return sign ? sign : &br_rsa_i31_pkcs1_sign;
+    }
+
+    /* prepare the key for the i31 engine before the signing on the other task, no preparation for other engines */
+    void prepare(esp_signer_rsa_engine engine)
+    {
+#if defined(USE_LIB_SSL_ENGINE)
+        if (isRSA() && !prepared.ready() && getRSASigner(engine) == &br_rsa_i31_pkcs1_sign)
+            prepared.prepare(&rsa);
+#endif
+    }
+
+    /* sign the hash with the selected engine, the i31 engine uses the key that was prepared at the first signing,
+    usePrepared is false when the prepared key workspace may be in use by the other task */
+    uint32_t sign(esp_signer_rsa_engine engine, const unsigned char *hash_oid, const unsigned char *hash, size_t hash_len, unsigned char *x, bool usePrepared = true)
+    {
+        if (!isRSA())
+            return 0;
+
+        br_rsa_pkcs1_sign sign = getRSASigner(engine);
+
+#if defined(USE_LIB_SSL_ENGINE)
+        if (usePrepared && sign == &br_rsa_i31_pkcs1_sign && (prepared.ready() || prepared.prepare(&rsa)))
+            return prepared.sign(hash_oid, hash, hash_len, x);
+#endif
+
+        return sign(hash_oid, hash, hash_len, &rsa, x);
+    }
+
+    /* the ECDSA signature of the SHA-256 hash in raw format (r || s), returns the signature length */
+    size_t signEC(const unsigned char *hash, unsigned char *sig)
+    {
+        if (!isEC())
+            return 0;
+        return br_ecdsa_sign_raw_get_default()(br_ec_get_default(), &br_sha256_vtable, hash, &ec, sig);
+    }
+
+    /* the key identity, the first 8 bytes of SHA-256 digest of the key components */
+    uint64_t getFingerprint() const { return fingerprint; }
+
+    /* wipe and release the decoded key */
+    void clear()
+    {
+#if defined(USE_LIB_SSL_ENGINE)
+        prepared.clear();
+#endif
+        if (buf)
+        {
+            volatile uint8_t *p = buf;
+            for (size_t i = 0; i < bufLen; i++)
+                p[i] = 0;
+            MemoryHelper::freeBuffer(mbfs, buf);
+        }
+        buf = nullptr;
+        bufLen = 0;
+        fingerprint = 0;
+        memset(&rsa, 0, sizeof(br_rsa_private_key));
+        memset(&ec, 0, sizeof(br_ec_private_key));
+    }
+
+private:
+    struct esp_signer_key_decoder_t
+    {
+        br_pem_decoder_context pem;
+        br_skey_decoder_context skey;
+        bool ended = false;
+        bool error = false;
+    };
+
+    MB_FS *mbfs = nullptr;
+    esp_signer_key_decoder_t *decoder = nullptr;
+    uint8_t *buf = nullptr;
+    size_t bufLen = 0;
+    br_rsa_private_key rsa;
+    br_ec_private_key ec;
+    uint64_t fingerprint = 0;
+#if defined(USE_LIB_SSL_ENGINE)
+    GAuth_RSA_Key prepared;
+#endif
+
+    static void skeyPush(void *ctx, const void *data, size_t len)
+    {
+        br_skey_decoder_push(reinterpret_cast<br_skey_decoder_context *>(ctx), data, len);
+    }
+
+    // wipe and release the decoder contexts, the key decoder holds the key components
+    void endDecoder()
+    {
+        if (decoder)
+        {
+            volatile uint8_t *p = reinterpret_cast<volatile uint8_t *>(decoder);
+            for (size_t i = 0; i < sizeof(esp_signer_key_decoder_t); i++)
+                p[i] = 0;
+            delete decoder;
+        }
+        decoder = nullptr;
+    }
+
+    // copy the key components into one buffer
+    bool store(const br_rsa_private_key *sk)
+    {
+        bufLen = sk->plen + sk->qlen + sk->dplen + sk->dqlen + sk->iqlen;
+        buf = MemoryHelper::createBuffer<uint8_t *>(mbfs, bufLen, false);
+
+        if (!buf)
+        {
+            bufLen = 0;
+            return false;
+        }
+
+        uint8_t *p = buf;
+        rsa.n_bitlen = sk->n_bitlen;
+        copy(p, rsa.p, rsa.plen, sk->p, sk->plen);
+        copy(p, rsa.q, rsa.qlen, sk->q, sk->qlen);
+        copy(p, rsa.dp, rsa.dplen, sk->dp, sk->dplen);
+        copy(p, rsa.dq, rsa.dqlen, sk->dq, sk->dqlen);
+        copy(p, rsa.iq, rsa.iqlen, sk->iq, sk->iqlen);
+        setFingerprint();
+        return true;
+    }
+
+    // copy the secret scalar, only P-256 is used for ES256
+    bool store(const br_ec_private_key *sk)
+    {
+        if (sk->curve != BR_EC_secp256r1)
+            return false;
+
+        bufLen = sk->xlen;
+        buf = MemoryHelper::createBuffer<uint8_t *>(mbfs, bufLen, false);
+
+        if (!buf)
+        {
+            bufLen = 0;
+            return false;
+        }
+
+        uint8_t *p = buf;
+        ec.curve = sk->curve;
+        copy(p, ec.x, ec.xlen, sk->x, sk->xlen);
+        setFingerprint();
+        return true;
+    }
+
+    void setFingerprint()
+    {
+        uint8_t hash[br_sha256_SIZE];
+        br_sha256_context mc;
+        br_sha256_init(&mc);
+        br_sha256_update(&mc, buf, bufLen);
+        br_sha256_out(&mc, hash);
+        fingerprint = 0;
+        for (int i = 0; i < 8; i++)
+            fingerprint = (fingerprint << 8) | hash[i];
+    }
+
+    void copy(uint8_t *&p, unsigned char *&dst, size_t &dstLen, const unsigned char *src, size_t srcLen)
+    {
+        memcpy(p, src, srcLen);
+        dst = p;
+        dstLen = srcLen;
+        p += srcLen;
+    }
+};
+
+#endif
@@ -48,18 +48,56 @@ void GAuth_OAuth2_Client::begin(esp_signer_gauth_cfg_t *cfg, MB_FS *mbfs, uint32
     this->mbfs = mbfs;
     this->mb_ts = mb_ts;
     this->mb_ts_offset = mb_ts_offset;
+    keyCache.begin(mbfs);
+    jwt.begin(mbfs);
+    prefetch.jwt.begin(mbfs);
+    jwtTemplate.begin(mbfs);
+    prefetchTemplate.begin(mbfs);
+    tokenSlot.begin(mbfs);
+
+    if (config)
+    {
+        // decode the private key once, it will be reused for every token signing
+        keyCache.clear();
+        if (config->service_account.json.path.length() > 0)
+            parseSAFile();
+        loadPrivateKey();
+
+        // the saved token is used when the clock is ready and it was issued for the same key and scopes
+        tokenStore.setFile(mbfs, config->token_cache.file, mbfs_type config->token_cache.file_storage);
+        tokenStore.load();
+
+        scheduler.begin(config->signer.jitterSeed);
+    }
 }
 
 void GAuth_OAuth2_Client::end()
 {
+    // the prefetch task uses the key and client
+    while (prefetchRunning())
+        Utils::idle();
+    prefetchState = esp_signer_gauth_prefetch_state_idle;
+    prefetch.token.clear();
+    prefetch.jwt.clear();
+
+    freeTokenRequest();
+    waiters.clear();
+    tokenStore.clear();
+    tokenSlot.clear();
     freeJson();
+    keyCache.clear();
+    jwt.clear();
+    jwtTemplate.clear();
+    prefetchTemplate.clear();
+    clearJWTCache();
 #if defined(ESP_SIGNER_HAS_WIFIMULTI)
     if (multi)
         delete multi;
     multi = nullptr;
 #endif
-    if (tcpClient)
+    if (tcpClient && !sharedTCPClient)
         freeClient(&tcpClient);
+    tcpClient = nullptr;
 }
 
 void GAuth_OAuth2_Client::newClient(GAuth_TCP_Client **client)
@@ -121,67 +159,75 @@ bool GAuth_OAuth2_Client::parseSAFile()
     if (res >= 0)
     {
         clearServiceAccountCreds();
-        initJson();
+        config->service_account.data.client_id.clear();
+
+        // the values are appended to the credentials,
+        // the private key is unescaped by the extractor and decoded into the key cache while the file is read
+        MB_String type;
+        MB_JSON_Extractor extractor;
+        int typeIdx = extractor.add(esp_signer_gauth_pgm_str_1 /* "type" */, &type);
+        extractor.add(esp_signer_gauth_pgm_str_3 /* "project_id" */, &config->service_account.data.project_id);
+        extractor.add(esp_signer_gauth_pgm_str_4 /* "private_key_id" */, &config->service_account.data.private_key_id);
+        extractor.add(esp_signer_gauth_pgm_str_5 /* "private_key" */, GAuth_Key_Cache::pemCallback, &keyCache);
+        extractor.add(esp_signer_gauth_pgm_str_6 /* "client_email" */, &config->service_account.data.client_email);
+        extractor.add(esp_signer_gauth_pgm_str_7 /* "client_id" */, &config->service_account.data.client_id);
+
+        keyCache.beginPEM();
 
         size_t len = res;
-        char *buf = MemoryHelper::createBuffer<char *>(mbfs, len + 10);
-        if (mbfs->available(mbfs_type config->service_account.json.storage_type))
+        char *buf = MemoryHelper::createBuffer<char *>(mbfs, ESP_SIGNER_SA_FILE_READ_WINDOW, false);
+
+        while (buf && len > 0 && !extractor.complete() && !extractor.error() &&
+               mbfs->available(mbfs_type config->service_account.json.storage_type))
         {
-            if ((int)len == mbfs->read(mbfs_type config->service_account.json.storage_type, (uint8_t *)buf, len))
-                jsonPtr->setJsonData(buf);
+            size_t n = len < ESP_SIGNER_SA_FILE_READ_WINDOW ? len : ESP_SIGNER_SA_FILE_READ_WINDOW;
+            int read = mbfs->read(mbfs_type config->service_account.json.storage_type, (uint8_t *)buf, n);
+            if (read <= 0)
+                break;
+
+            extractor.parse(buf, read);
+            len -= read;
+            Utils::idle();
         }
 
         mbfs->close(mbfs_type config->service_account.json.storage_type);
 
-        if (JsonHelper::parse(jsonPtr, resultPtr, esp_signer_gauth_pgm_str_1)) // type
+        if (buf)
         {
-            if (resultPtr->to<MB_String>().find(pgm2Str(esp_signer_gauth_pgm_str_2 /* service_account */), 0) != MB_String::npos)
-            {
-                if (JsonHelper::parse(jsonPtr, resultPtr, esp_signer_gauth_pgm_str_3)) // project_id
-                    config->service_account.data.project_id = resultPtr->to<const char *>();
+            memset(buf, 0, ESP_SIGNER_SA_FILE_READ_WINDOW);
+            MemoryHelper::freeBuffer(mbfs, buf);
+        }
 
-                if (JsonHelper::parse(jsonPtr, resultPtr, esp_signer_gauth_pgm_str_4)) // private_key_id
-                    config->service_account.data.private_key_id = resultPtr->to<const char *>();
+        bool keyReady = keyCache.endPEM();
 
-                if (JsonHelper::parse(jsonPtr, resultPtr, esp_signer_gauth_pgm_str_5)) // private_key
-                {
-                    char *temp = MemoryHelper::createBuffer<char *>(mbfs, strlen(resultPtr->to<const char *>()));
-                    size_t c = 0;
-                    for (size_t i = 0; i < strlen(resultPtr->to<const char *>()); i++)
-                    {
-                        if (resultPtr->to<const char *>()[i] == '\\')
-                        {
-                            Utils::idle();
-                            temp[c++] = '\n';
-                            i++;
-                        }
-                        else
-                            temp[c++] = resultPtr->to<const char *>()[i];
-                    }
-                    config->signer.pk = temp;
-                    resultPtr->clear();
-                    MemoryHelper::freeBuffer(mbfs, temp);
-                }
+        if (keyReady && extractor.found(typeIdx) &&
+            type.find(pgm2Str(esp_signer_gauth_pgm_str_2 /* service_account */), 0) != MB_String::npos)
+            return true;
 
-                if (JsonHelper::parse(jsonPtr, resultPtr, esp_signer_gauth_pgm_str_6)) // client_email
-                    config->service_account.data.client_email = resultPtr->to<const char *>();
-                if (JsonHelper::parse(jsonPtr, resultPtr, esp_signer_gauth_pgm_str_7)) // client_id
-                    config->service_account.data.client_id = resultPtr->to<const char *>();
+        clearServiceAccountCreds();
+        config->service_account.data.client_id.clear();
+    }
 
-                freeJson();
+    return false;
+}
 
-                MemoryHelper::freeBuffer(mbfs, buf);
+bool GAuth_OAuth2_Client::loadPrivateKey()
+{
+    if (keyCache.ready())
+        return true;
 
-                return true;
-            }
-        }
+    bool ret = false;
 
-        freeJson();
+    if (config->signer.pk.length() > 0)
+        ret = keyCache.load(config->signer.pk.c_str());
+    else if (strlen_P(config->service_account.data.private_key) > 0)
+        ret = keyCache.load(config->service_account.data.private_key);
 
-        MemoryHelper::freeBuffer(mbfs, buf);
-    }
+    // the PEM text is not needed once it was decoded
+    if (ret)
+        config->signer.pk.clear();
 
-    return false;
+    return ret;
 }
 
 void GAuth_OAuth2_Client::clearServiceAccountCreds()
@@ -191,11 +237,12 @@ void GAuth_OAuth2_Client::clearServiceAccountCreds()
     config->service_account.data.private_key_id.clear();
     config->service_account.data.client_email.clear();
     config->signer.pk.clear();
+    keyCache.clear();
 }
 
 bool GAuth_OAuth2_Client::serviceAccountCredsReady()
 {
-    return (strlen_P(config->service_account.data.private_key) > 0 || config->signer.pk.length() > 0) &&
+    return (keyCache.ready() || strlen_P(config->service_account.data.private_key) > 0 || config->signer.pk.length() > 0) &&
            config->service_account.data.client_email.length() > 0 &&
            config->service_account.data.project_id.length() > 0;
 }
@@ -251,8 +298,12 @@ bool GAuth_OAuth2_Client::isExpired()
     // adjust the expiry time when needed
     adjustTime(now);
 
+    unsigned long lead = scheduler.refreshLead(config->signer.preRefreshSeconds, refreshJitter(), config->signer.tokens.expires);
+    if (lead > config->signer.tokens.expires)
+        lead = config->signer.tokens.expires;
+
     // time is up or expiry time was reset or unset?
-    return (now > (int)(config->signer.tokens.expires - config->signer.preRefreshSeconds) || config->signer.tokens.expires == 0);
+    return (now > (int)(config->signer.tokens.expires - lead) || config->signer.tokens.expires == 0);
 }
 
 void GAuth_OAuth2_Client::adjustTime(time_t &now)
@@ -284,10 +335,33 @@ bool GAuth_OAuth2_Client::readyToRequest()
 
 bool GAuth_OAuth2_Client::readyToRefresh()
 {
-    if (!config)
-        return false;
-    // To detain the next request using lat request millis
-    return millis() - config->internal.last_request_token_cb_millis > 5000;
+    return config && refreshWait() == 0;
+}
+
+unsigned long GAuth_OAuth2_Client::refreshWait()
+{
+    // To detain the next request using lat request millis, the interval grows after the failed requests
+    unsigned long delay = scheduler.retryDelay(config->timeout.tokenRequestRetry);
+
+    // the first request after the boot is also spread by the jitter
+    if (config->internal.last_request_token_cb_millis == 0)
+    {
+        unsigned long start = scheduler.startDelay(refreshJitter() * 1000);
+        if (start > delay)
+            delay = start;
+    }
+
+    unsigned long elapsed = millis() - config->internal.last_request_token_cb_millis;
+    return elapsed > delay ? 0 : delay - elapsed + 1;
+}
+
+unsigned long GAuth_OAuth2_Client::refreshJitter()
+{
+    // the jitter should not be more than half of the token lifetime
+    unsigned long jitter = config->signer.refreshJitterSeconds;
+    if (jitter > config->signer.expiredSeconds / 2)
+        jitter = config->signer.expiredSeconds / 2;
+    return jitter;
 }
 
 bool GAuth_OAuth2_Client::readyToSync()
@@ -337,6 +411,10 @@ bool GAuth_OAuth2_Client::handleToken()
     if (!config)
         return false;
 
+    // the next token is being requested, keep the current token until it is done
+    if (prefetchRunning())
+        return config->signer.tokens.status == esp_signer_token_status_ready;
+
     // time is up or expiey time reset or unset
     bool exp = isExpired();
 
@@ -357,12 +435,18 @@ bool GAuth_OAuth2_Client::handleToken()
             {
 
                 bool use_sa_key_file = false, valid_key_file = false;
-                // If service account key json file assigned and no private key parsing data
-                if (config->service_account.json.path.length() > 0 && config->signer.pk.length() == 0)
+                // If the private key was not decoded at begin e.g. the storage was not ready
+                if (!keyCache.ready())
                 {
-                    use_sa_key_file = true;
-                    // Parse the private key from service account json file
-                    valid_key_file = parseSAFile();
+                    // If service account key json file assigned and no private key parsing data
+                    if (config->service_account.json.path.length() > 0 && config->signer.pk.length() == 0)
+                    {
+                        use_sa_key_file = true;
+                        // Parse the private key from service account json file
+                        valid_key_file = parseSAFile();
+                    }
+
+                    loadPrivateKey();
                 }
 
                 // Check the SA creds
@@ -403,22 +487,62 @@ bool GAuth_OAuth2_Client::handleToken()
     return config->signer.tokens.status == esp_signer_token_status_ready;
 }
 
+bool GAuth_OAuth2_Client::restoreToken()
+{
+    if (config->signer.tokens.token_type != token_type_oauth2_access_token ||
+        !tokenStore.match(keyCache.getFingerprint(), GAuth_Token_Store::scopeId(config)))
+        return false;
+
+    time_t now = getTime();
+
+    if ((unsigned long)now < ESP_SIGNER_DEFAULT_TS)
+        return false;
+
+    // the token should be valid longer than the pre-refresh period
+    if ((time_t)tokenStore.expires() <= now + (time_t)config->signer.preRefreshSeconds)
+    {
+        tokenStore.clear();
+        return false;
+    }
+
+    config->signer.tokens.expires = tokenStore.expires();
+    tokenStore.take(config->internal.auth_token);
+    publishToken();
+    config->signer.tokens.last_millis = millis();
+    config->signer.tokens.error.code = 0;
+    config->signer.tokens.error.message.clear();
+    config->signer.tokens.status = esp_signer_token_status_ready;
+    config->signer.step = esp_signer_gauth_jwt_generation_step_begin;
+    sendTokenStatusCB();
+
+    return true;
+}
+
+void GAuth_OAuth2_Client::saveToken()
+{
+    if (!tokenStore.fileReady() || config->signer.tokens.token_type != token_type_oauth2_access_token ||
+        config->signer.tokens.expires < ESP_SIGNER_DEFAULT_TS || keyCache.getFingerprint() == 0)
+        return;
+
+    tokenStore.save(keyCache.getFingerprint(), GAuth_Token_Store::scopeId(config), config->internal.auth_token, config->signer.tokens.expires);
+}
+
+void GAuth_OAuth2_Client::publishToken()
+{
+    tokenSlot.publish(config->internal.auth_token);
+}
+
 void GAuth_OAuth2_Client::initJson()
 {
     if (!jsonPtr)
         jsonPtr = new FirebaseJson();
-    if (!resultPtr)
-        resultPtr = new FirebaseJsonData();
 }
 
 void GAuth_OAuth2_Client::freeJson()
 {
     if (jsonPtr)
         delete jsonPtr;
-    if (resultPtr)
-        delete resultPtr;
     jsonPtr = nullptr;
-    resultPtr = nullptr;
 }
 
 void GAuth_OAuth2_Client::tryGetTime()
@@ -506,7 +630,16 @@ void GAuth_OAuth2_Client::tokenProcessingTask()
             config->internal.last_jwt_begin_step_millis = millis();
 
             if (config->internal.clock_rdy)
-                config->signer.step = esp_signer_gauth_jwt_generation_step_encode_header_payload;
+            {
+                // the saved token is still valid, exit loop
+                if (restoreToken())
+                {
+                    _token_processing_task_enable = false;
+                    ret = true;
+                }
+                else
+                    config->signer.step = esp_signer_gauth_jwt_generation_step_encode_header_payload;
+            }
         }
         // encode the JWT token
         else if (config->signer.step == esp_signer_gauth_jwt_generation_step_encode_header_payload)
@@ -518,28 +651,68 @@ void GAuth_OAuth2_Client::tokenProcessingTask()
         else if (config->signer.step == esp_signer_gauth_jwt_generation_step_sign)
         {
             if (createJWT())
-                config->signer.step = esp_signer_gauth_jwt_generation_step_exchange;
+            {
+                if (config->signer.tokens.token_type == token_type_self_signed_jwt)
+                {
+                    // the signed JWT is the token, exit loop
+                    handleSelfSignedJWT();
+                    _token_processing_task_enable = false;
+                    ret = true;
+                }
+                else
+                    config->signer.step = esp_signer_gauth_jwt_generation_step_exchange;
+            }
         }
         // sending JWT token requst for auth token
         else if (config->signer.step == esp_signer_gauth_jwt_generation_step_exchange)
         {
 
-            if (readyToRefresh())
+            if (tokenRequest || readyToRefresh())
             {
-                // sending a new request
-                ret = requestTokens(false);
+                bool done = true;
 
-                // send error cb
-                if (!reconnect())
-                    handleTaskError(ESP_SIGNER_ERROR_TCP_ERROR_CONNECTION_LOST);
+                if (config->signer.stepBudgetMs == 0)
+                {
+                    // sending a new request
+                    ret = requestTokens(false);
+                }
+                else if (tokenRequest)
+                {
+                    // connect, send or read the response
+                    ret = stepTokenRequest(config->signer.stepBudgetMs, done);
+                }
+                else
+                {
+                    // the request is prepared, it will be sent in the next calls
+                    ret = false;
+                    done = !beginTokenRequest(false);
+                }
+
+                if (done)
+                {
+                    // send error cb
+                    if (!reconnect())
+                        handleTaskError(ESP_SIGNER_ERROR_TCP_ERROR_CONNECTION_LOST);
 
-                // reset state and exit loop
-                config->signer.step = ret || getTime() - now > 3599 ? esp_signer_gauth_jwt_generation_step_begin : esp_signer_gauth_jwt_generation_step_exchange;
+                    // reset state and exit loop
+                    config->signer.step = ret || getTime() - now > 3599 ? esp_signer_gauth_jwt_generation_step_begin : esp_signer_gauth_jwt_generation_step_exchange;
+
+                    _token_processing_task_enable = false;
+                }
 
-                _token_processing_task_enable = false;
                 ret = true;
             }
+            else if (refreshWait() > ESP_SIGNER_MAX_TOKEN_REQUEST_WAIT)
+            {
+                // the backoff and start delay space out the requests, the request is sent by the later call
+                _token_processing_task_enable = false;
+                break;
+            }
         }
+
+        // one step per call, the next step is processed in the next call
+        if (config->signer.stepBudgetMs > 0)
+            break;
     }
 
     // reset task running status
@@ -554,19 +727,26 @@ bool GAuth_OAuth2_Client::refreshToken()
 
     if (config->signer.tokens.status == esp_signer_token_status_on_request ||
         config->signer.tokens.status == esp_signer_token_status_on_refresh ||
-        config->internal.processing)
+        config->internal.processing || prefetchRunning())
         return false;
 
     if (config->internal.refresh_token.length() == 0 && config->internal.auth_token.length() == 0)
         return false;
 
-    if (!initClient(esp_signer_gauth_pgm_str_8 /* "securetoken" */, esp_signer_token_status_on_refresh))
+    esp_signer_gauth_token_request_t r;
+    r.refresh = true;
+    r.keepAlive = config->signer.keepAlive;
+    r.timeout = serverResponseTimeout();
+
+    if (!initClient(esp_signer_gauth_pgm_str_8 /* "securetoken" */, esp_signer_token_status_on_refresh, r.resend))
         return false;
 
+    initJson();
+
     jsonPtr->add(pgm2Str(esp_signer_gauth_pgm_str_9 /* "grantType" */), pgm2Str(esp_signer_gauth_pgm_str_10 /* "refresh_token" */));
     jsonPtr->add(pgm2Str(esp_signer_gauth_pgm_str_11 /* "refreshToken" */), config->internal.refresh_token.c_str());
 
-    MB_String req;
+    MB_String &req = r.req;
     HttpHelper::addRequestHeaderFirst(req, http_post);
 
     req += esp_signer_gauth_pgm_str_12; // "/v1/token?Key=""
@@ -575,31 +755,39 @@ bool GAuth_OAuth2_Client::refreshToken()
 
     HttpHelper::addGAPIsHostHeader(req, esp_signer_gauth_pgm_str_8 /* "securetoken" */);
     HttpHelper::addUAHeader(req);
+    HttpHelper::addConnectionHeader(req, config->signer.keepAlive);
     HttpHelper::addContentLengthHeader(req, strlen(jsonPtr->raw()));
     HttpHelper::addContentTypeHeader(req, esp_signer_gauth_pgm_str_13 /* "application/json" */);
     HttpHelper::addNewLine(req);
 
     req += jsonPtr->raw(); // {"grantType":"refresh_token","refreshToken":"<refresh token>"}
 
-    tcpClient->send(req.c_str());
+    struct esp_signer_gauth_auth_token_error_t error;
+
+    // the response fields are extracted while the response is read
+    MB_JSON_Extractor &extractor = r.extractor;
+    r.expiresIdx = extractor.add(esp_signer_gauth_pgm_str_19 /* "expires_in" */, r.expiresIn, sizeof(r.expiresIn));
+    r.codeIdx = extractor.add(esp_signer_gauth_pgm_str_14 /* "error/code" */, r.errorCode, sizeof(r.errorCode));
+    r.messageIdx = extractor.add(esp_signer_gauth_pgm_str_15 /* "error/message" */, &r.errorMessage);
+
+    bool received = sendRequest(r);
 
     req.clear();
-    if (response_code < 0)
+    if (!r.sent)
+    {
+        setRequestResult(false);
         return handleTaskError(ESP_SIGNER_ERROR_TCP_ERROR_CONNECTION_LOST);
+    }
 
-    struct esp_signer_gauth_auth_token_error_t error;
-
-    int httpCode = ESP_SIGNER_ERROR_HTTP_CODE_REQUEST_TIMEOUT;
-    MB_String payload;
-    if (handleResponse(tcpClient, httpCode, payload))
+    if (received)
     {
-        if (JsonHelper::parse(jsonPtr, resultPtr, esp_signer_gauth_pgm_str_14 /* "error/code" */))
+        if (extractor.found(r.codeIdx))
         {
-            error.code = resultPtr->to<int>();
+            error.code = atoi(r.errorCode);
             config->signer.tokens.status = esp_signer_token_status_error;
 
-            if (JsonHelper::parse(jsonPtr, resultPtr, esp_signer_gauth_pgm_str_15 /* "error/message" */))
-                error.message = resultPtr->to<const char *>();
+            if (extractor.found(r.messageIdx))
+                error.message = r.errorMessage;
         }
 
         config->signer.tokens.error = error;
@@ -612,16 +800,19 @@ bool GAuth_OAuth2_Client::refreshToken()
         if (error.code == 0)
         {
 
-            if (JsonHelper::parse(jsonPtr, resultPtr, esp_signer_gauth_pgm_str_19 /* "expires_in" */))
-                getExpiration(resultPtr->to<const char *>());
+            if (extractor.found(r.expiresIdx))
+                getExpiration(r.expiresIn);
 
+            setRequestResult(true);
             return handleTaskError(ESP_SIGNER_ERROR_TOKEN_COMPLETE_NOTIFY);
         }
 
+        setRequestResult(false, r.retryAfter);
         return handleTaskError(ESP_SIGNER_ERROR_TOKEN_ERROR_UNNOTIFY);
     }
 
-    return handleTaskError(ESP_SIGNER_ERROR_HTTP_CODE_REQUEST_TIMEOUT, httpCode);
+    setRequestResult(false, r.retryAfter);
+    return handleTaskError(ESP_SIGNER_ERROR_HTTP_CODE_REQUEST_TIMEOUT, r.httpCode);
 }
 
 void GAuth_OAuth2_Client::setTokenError(int code)
@@ -645,8 +836,15 @@ void GAuth_OAuth2_Client::setTokenError(int code)
 
 bool GAuth_OAuth2_Client::handleTaskError(int code, int httpCode)
 {
+    // Keep the TCP connection open only when the response was completely read in keep-alive mode
+    bool keepSession = config->signer.keepAlive &&
+                       (code == ESP_SIGNER_ERROR_TOKEN_COMPLETE_NOTIFY ||
+                        code == ESP_SIGNER_ERROR_TOKEN_COMPLETE_UNNOTIFY ||
+                        code == ESP_SIGNER_ERROR_TOKEN_ERROR_UNNOTIFY);
+
     // Close TCP connection and unlock used flag
-    tcpClient->stop();
+    if (!keepSession)
+        tcpClient->stop();
     config->internal.processing = false;
 
     switch (code)
@@ -685,7 +883,8 @@ bool GAuth_OAuth2_Client::handleTaskError(int code, int httpCode)
     }
 
     // Free memory
-    tcpClient->stop();
+    if (!keepSession)
+        tcpClient->stop();
     freeJson();
 
     // reset token processing state
@@ -710,105 +909,51 @@ void GAuth_OAuth2_Client::sendTokenStatusCB()
     tokenInfo.type = config->signer.tokens.token_type;
     tokenInfo.error = config->signer.tokens.error;
 
-    if (config->token_status_callback && isErrorCBTimeOut())
-        config->token_status_callback(tokenInfo);
-}
-
-bool GAuth_OAuth2_Client::handleResponse(GAuth_TCP_Client *client, int &httpCode, MB_String &payload, bool stopSession)
-{
-    if (!reconnect(client))
-        return false;
-
-    MB_String header;
-
-    struct esp_signer_server_response_data_t response;
-    struct esp_signer_tcp_response_handler_t tcpHandler;
-
-    HttpHelper::intTCPHandler(client, tcpHandler, 2048, 2048, nullptr);
-
-    while (client->connected() && client->available() == 0)
+    if ((config->token_status_callback || config->token_status_ref_callback) && isErrorCBTimeOut())
     {
-        Utils::idle();
-        if (!reconnect(client, tcpHandler.dataTime))
-            return false;
+        if (config->token_status_callback)
+            config->token_status_callback(tokenInfo);
+        if (config->token_status_ref_callback)
+            config->token_status_ref_callback(tokenInfo);
     }
+}
 
-    bool complete = false;
+bool GAuth_OAuth2_Client::readResponse(GAuth_TCP_Client *client, esp_signer_gauth_token_request_t &r, bool stopSession)
+{
+    r.retryAfter = -1;
 
-    tcpHandler.chunkBufSize = tcpHandler.defaultChunkSize;
+    // the prefetch task reads the response too, only the request fields are used
+    if (!client->networkReady())
+        return false;
 
-    char *pChunk = MemoryHelper::createBuffer<char *>(mbfs, tcpHandler.chunkBufSize + 1);
+    GAuth_HTTP_Parser &parser = r.parser;
+    parser = GAuth_HTTP_Parser(&r.sink);
+    unsigned long dataTime = millis();
 
-    while (tcpHandler.available() || !complete)
+    while (!parser.complete() && !parser.error())
     {
         Utils::idle();
 
-        if (!reconnect(client, tcpHandler.dataTime))
-            break;
-
-        if (!HttpHelper::readStatusLine(mbfs, client, tcpHandler, response))
+        if (parser.read(client) > 0)
+            dataTime = millis();
+        else if (!client->connected())
         {
-            // The next chunk data can be the remaining http header
-            if (tcpHandler.isHeader)
-            {
-                // Read header, complete?
-                if (HttpHelper::readHeader(mbfs, client, tcpHandler, response))
-                {
-                    if (response.httpCode == ESP_SIGNER_ERROR_HTTP_CODE_NO_CONTENT)
-                        tcpHandler.error.code = 0;
-
-                    if (Utils::isNoContent(&response))
-                        break;
-                }
-            }
-            else
-            {
-                memset(pChunk, 0, tcpHandler.chunkBufSize + 1);
-
-                // Read the avilable data
-                // chunk transfer encoding?
-                if (response.isChunkedEnc)
-                    tcpHandler.bufferAvailable = HttpHelper::readChunkedData(mbfs, client,
-                                                                             pChunk, nullptr, tcpHandler);
-                else
-                    tcpHandler.bufferAvailable = HttpHelper::readLine(client,
-                                                                      pChunk, tcpHandler.chunkBufSize);
-
-                if (tcpHandler.bufferAvailable > 0)
-                {
-                    tcpHandler.payloadRead += tcpHandler.bufferAvailable;
-                    payload += pChunk;
-                }
-
-                if (Utils::isChunkComplete(&tcpHandler, &response, complete) ||
-                    Utils::isResponseComplete(&tcpHandler, &response, complete))
-                {
-
-                    break;
-                }
-            }
+            // The session was closed, only the payload without content length can be completed
+            parser.end();
+            break;
         }
+        else if (millis() - dataTime > r.timeout || !client->networkReady())
+            break;
     }
 
-    // To make sure all chunks read
-    if (response.isChunkedEnc)
-        client->flush();
-
-    MemoryHelper::freeBuffer(mbfs, pChunk);
-
-    if (stopSession && client->connected())
+    // The server may close the kept-alive session, the incomplete response leaves the session unusable
+    if ((stopSession || parser.connectionClose || !parser.complete()) && client->connected())
         client->stop();
 
-    httpCode = response.httpCode;
-
-    if (jsonPtr && payload.length() > 0 && !response.noContent)
-    {
-        // Just a simple JSON which is suitable for parsing in low memory device
-        jsonPtr->setJsonData(payload.c_str());
-        return true;
-    }
+    r.httpCode = parser.httpCode;
+    r.retryAfter = parser.retryAfter;
 
-    return httpCode == ESP_SIGNER_ERROR_HTTP_CODE_OK;
+    return parser.complete();
 }
 
 bool GAuth_OAuth2_Client::createJWT()
@@ -821,102 +966,9 @@ bool GAuth_OAuth2_Client::createJWT()
         config->internal.last_jwt_generation_error_cb_millis = 0;
         sendTokenStatusCB();
 
-        time_t now = getTime();
-
-        initJson();
-
-        config->signer.tokens.jwt.clear();
-
-        // header
-        // {"alg":"RS256","typ":"JWT"}
-        jsonPtr->add(pgm2Str(esp_signer_gauth_pgm_str_20 /* "alg" */), pgm2Str(esp_signer_gauth_pgm_str_21 /* "RS256" */));
-        jsonPtr->add(pgm2Str(esp_signer_gauth_pgm_str_22 /* "typ" */), pgm2Str(esp_signer_gauth_pgm_str_23 /* "JWT" */));
-
-        size_t len = Base64Helper::encodedLength(strlen(jsonPtr->raw()));
-        char *buf = MemoryHelper::createBuffer<char *>(mbfs, len);
-        Base64Helper::encodeUrl(mbfs, buf, (unsigned char *)jsonPtr->raw(), strlen(jsonPtr->raw()));
-        config->signer.encHeader = buf;
-        MemoryHelper::freeBuffer(mbfs, buf);
-        config->signer.encHeadPayload = config->signer.encHeader;
-
-        // payload
-        // {"iss":"<email>","sub":"<email>","aud":"<audience>","iat":<timstamp>,"exp":<expire>,"scope":"<scope>"}
-        // {"iss":"<email>","sub":"<email>","aud":"<audience>","iat":<timstamp>,"exp":<expire>,"uid":"<uid>","claims":"<claims>"}
-        jsonPtr->clear();
-        jsonPtr->add(pgm2Str(esp_signer_gauth_pgm_str_24 /* "iss" */), config->service_account.data.client_email.c_str());
-        jsonPtr->add(pgm2Str(esp_signer_gauth_pgm_str_25 /* "sub" */), config->service_account.data.client_email.c_str());
-
-        MB_String t = esp_signer_gauth_pgm_str_26; // "https://"
-        HttpHelper::addGAPIsHost(t, esp_signer_gauth_pgm_str_27 /* "oauth2" */);
-        t += esp_signer_gauth_pgm_str_28; // "/"
-        t += esp_signer_gauth_pgm_str_29; // "token"
-
-        jsonPtr->add(pgm2Str(esp_signer_gauth_pgm_str_30 /* "aud" */), t.c_str());
-        jsonPtr->add(pgm2Str(esp_signer_gauth_pgm_str_31 /* "iat" */), (int)now);
-
-        if (config->signer.expiredSeconds > 3600)
-            jsonPtr->add(pgm2Str(esp_signer_gauth_pgm_str_32 /* "exp" */), (int)(now + 3600));
-        else
-            jsonPtr->add(pgm2Str(esp_signer_gauth_pgm_str_32 /* "exp" */), (int)(now + config->signer.expiredSeconds));
-
-        MB_String s;
-
-        if (config->signer.tokens.scope.length() > 0)
-        {
-            std::vector<MB_String> scopes = std::vector<MB_String>();
-            StringHelper::splitTk(config->signer.tokens.scope, scopes, ",");
-            for (size_t i = 0; i < scopes.size(); i++)
-            {
-                if (s.length() > 0)
-                    s += esp_signer_pgm_str_15;
-                s += scopes[i];
-                scopes[i].clear();
-            }
-            scopes.clear();
-            jsonPtr->add(pgm2Str(esp_signer_gauth_pgm_str_33 /* "scope" */), s.c_str());
-        }
-        else
-            jsonPtr->add(pgm2Str(esp_signer_gauth_pgm_str_33 /* "scope" */), pgm2Str(esp_signer_gauth_pgm_str_46 /* "https://www.googleapis.com/auth/cloud-platform" */));
-
-        len = Base64Helper::encodedLength(strlen(jsonPtr->raw()));
-        buf = MemoryHelper::createBuffer<char *>(mbfs, len);
-        Base64Helper::encodeUrl(mbfs, buf, (unsigned char *)jsonPtr->raw(), strlen(jsonPtr->raw()));
-        config->signer.encPayload = buf;
-        MemoryHelper::freeBuffer(mbfs, buf);
-
-        config->signer.encHeadPayload += esp_signer_gauth_pgm_str_35; // "."
-        config->signer.encHeadPayload += config->signer.encPayload;
-
-        config->signer.encHeader.clear();
-        config->signer.encPayload.clear();
-
-        // create message digest from encoded header and payload
-        config->signer.hash = MemoryHelper::createBuffer<char *>(mbfs, config->signer.hashSize);
-        br_sha256_context mc;
-        br_sha256_init(&mc);
-        br_sha256_update(&mc, config->signer.encHeadPayload.c_str(), config->signer.encHeadPayload.length());
-        br_sha256_out(&mc, config->signer.hash);
-
-        config->signer.tokens.jwt = config->signer.encHeadPayload;
-        config->signer.tokens.jwt += esp_signer_gauth_pgm_str_35; // "."
-        config->signer.encHeadPayload.clear();
-
-        freeJson();
-    }
-    else if (config->signer.step == esp_signer_gauth_jwt_generation_step_sign)
-    {
-        config->signer.tokens.status = esp_signer_token_status_on_signing;
-
-        // RSA private key
-        PrivateKey *pk = nullptr;
+        // the private key, decoded once and kept in the key cache, its type selects the JWT algorithm
         Utils::idle();
-        // parse priv key
-        if (config->signer.pk.length() > 0)
-            pk = new PrivateKey((const char *)config->signer.pk.c_str());
-        else if (strlen_P(config->service_account.data.private_key) > 0)
-            pk = new PrivateKey((const char *)config->service_account.data.private_key);
-
-        if (!pk)
+        if (!loadPrivateKey())
         {
             setTokenError(ESP_SIGNER_ERROR_TOKEN_PARSE_PK);
             config->signer.tokens.error.message.insert(0, (const char *)FPSTR("BearSSL, PrivateKey: "));
@@ -924,47 +976,35 @@ bool GAuth_OAuth2_Client::createJWT()
             return false;
         }
 
-        if (!pk->isRSA())
+        if (!keyCache.isRSA() && !keyCache.isEC())
         {
             setTokenError(ESP_SIGNER_ERROR_TOKEN_PARSE_PK);
-            config->signer.tokens.error.message.insert(0, (const char *)FPSTR("BearSSL, isRSA: "));
+            config->signer.tokens.error.message.insert(0, (const char *)FPSTR("BearSSL, RSA or P-256 key: "));
             sendTokenStatusCB();
-            delete pk;
-            pk = nullptr;
             return false;
         }
 
-        const br_rsa_private_key *br_rsa_key = pk->getRSA();
+        // the signature size of the key e.g. 128, 256, 384 and 512 bytes for 1024, 2048, 3072 and 4096 bits RSA key
+        config->signer.signatureSize = keyCache.signatureLength();
 
-        // generate RSA signature from private key and message digest
-        config->signer.signature = new unsigned char[config->signer.signatureSize];
+        // the self-signed JWT uses the API audience, the assertion uses the OAuth2.0 token endpoint
+        if (!encodeJWT(jwt, config->signer.tokens.token_type == token_type_self_signed_jwt ? config->signer.tokens.audience.c_str() : nullptr,
+                       &jwtTemplate, jwtExpires))
+            return false;
 
-        Utils::idle();
-        int ret = br_rsa_i15_pkcs1_sign(BR_HASH_OID_SHA256, (const unsigned char *)config->signer.hash,
-                                        br_sha256_SIZE, br_rsa_key, config->signer.signature);
-        Utils::idle();
-        MemoryHelper::freeBuffer(mbfs, config->signer.hash);
-
-        size_t len = Base64Helper::encodedLength(config->signer.signatureSize);
-        char *buf = MemoryHelper::createBuffer<char *>(mbfs, len);
-        Base64Helper::encodeUrl(mbfs, buf, config->signer.signature, config->signer.signatureSize);
-        config->signer.encSignature = buf;
-        MemoryHelper::freeBuffer(mbfs, buf);
-        MemoryHelper::freeBuffer(mbfs, config->signer.signature);
-        delete pk;
-        pk = nullptr;
-
-        // get the signed JWT
-        if (ret > 0)
-        {
-            config->signer.tokens.jwt += config->signer.encSignature;
-            config->signer.pk.clear();
-            config->signer.encSignature.clear();
-        }
-        else
+        jwt.writeP(esp_signer_gauth_pgm_str_35); // "."
+    }
+    else if (config->signer.step == esp_signer_gauth_jwt_generation_step_sign)
+    {
+        config->signer.tokens.status = esp_signer_token_status_on_signing;
+
+        if (!signJWT(jwt))
         {
             setTokenError(ESP_SIGNER_ERROR_TOKEN_SIGN);
-            config->signer.tokens.error.message.insert(0, (const char *)FPSTR("BearSSL, br_rsa_i15_pkcs1_sign: "));
+            if (keyCache.isEC())
+                config->signer.tokens.error.message.insert(0, (const char *)FPSTR("BearSSL, br_ecdsa_sign_raw: "));
+            else
+                config->signer.tokens.error.message.insert(0, (const char *)FPSTR("BearSSL, br_rsa_pkcs1_sign: "));
             sendTokenStatusCB();
             return false;
         }
@@ -973,121 +1013,552 @@ bool GAuth_OAuth2_Client::createJWT()
     return true;
 }
 
-bool GAuth_OAuth2_Client::initClient(PGM_P subDomain, esp_signer_gauth_auth_token_status status)
+bool GAuth_OAuth2_Client::encodeJWT(GAuth_JWT_Writer &writer, const char *audience, GAuth_JWT_Template *tpl, unsigned long &expires)
 {
+    uint32_t now = getTime();
+    uint32_t exp = now + (config->signer.expiredSeconds > 3600 ? 3600 : config->signer.expiredSeconds);
+    size_t signatureLen = 1 + GAuth_JWT_Writer::encodedLength(keyCache.signatureLength());
+    uint64_t id = 0;
 
-    Utils::idle();
-
-    if (status != esp_signer_token_status_uninitialized)
+    if (tpl)
     {
-        config->signer.tokens.status = status;
-        config->internal.processing = true;
-        config->signer.tokens.error.code = 0;
-        config->signer.tokens.error.message.clear();
-        config->internal.last_jwt_generation_error_cb_millis = 0;
-        config->internal.last_request_token_cb_millis = millis();
-        sendTokenStatusCB();
-    }
+        id = GAuth_JWT_Template::identity(config->service_account.data.client_email.c_str(), audience,
+                                          config->signer.tokens.scope.c_str(), keyCache.getFingerprint());
 
-    // stop the TCP session
-    tcpClient->stop();
+        // the claims and key are unchanged, only the timestamps are rewritten
+        if (tpl->matches(id) && tpl->stamp(writer, now, exp, signatureLen))
+        {
+            expires = exp;
+            return true;
+        }
+    }
 
-    tcpClient->setCACert(nullptr);
+    // count the JWT length first, then write it into the buffer that also has room for the signature
+    writer.measure();
+    writeJWT(writer, now, exp, audience);
 
-    if (!reconnect(tcpClient))
+    if (!writer.reserve(writer.length() + signatureLen))
         return false;
 
-    tcpClient->setBufferSizes(2048, 1024);
+    writeJWT(writer, now, exp, audience);
 
-    initJson();
+    // create message digest from encoded header and payload
+    writer.digest();
 
-    MB_String host;
-    HttpHelper::addGAPIsHost(host, subDomain);
+    if (tpl)
+        tpl->compile(writer, id);
 
-    Utils::idle();
-    tcpClient->begin(host.c_str(), 443, &response_code);
+    expires = exp;
 
     return true;
 }
 
-bool GAuth_OAuth2_Client::requestTokens(bool refresh)
+bool GAuth_OAuth2_Client::signJWT(GAuth_JWT_Writer &writer, bool forPrefetch)
 {
-    time_t now = getTime();
-
-    if (config->signer.tokens.status == esp_signer_token_status_on_request ||
-        config->signer.tokens.status == esp_signer_token_status_on_refresh ||
-        ((unsigned long)now < ESP_SIGNER_DEFAULT_TS && !refresh) ||
-        config->internal.processing)
-        return false;
-
-    if (!initClient(esp_signer_gauth_pgm_str_36 /* "www" */, refresh ? esp_signer_token_status_on_refresh : esp_signer_token_status_on_request))
+    if (!keyCache.isRSA() && !keyCache.isEC())
         return false;
 
-    MB_String req;
-    HttpHelper::addRequestHeaderFirst(req, http_post);
-
-    if (refresh)
-    {
-        // {"client_id":"<client id>","client_secret":"<client secret>","grant_type":"refresh_token",
-        // "refresh_token":"<refresh token>"}
-        jsonPtr->add(pgm2Str(esp_signer_gauth_pgm_str_7 /* "client_id" */), config->internal.client_id.c_str());
-        jsonPtr->add(pgm2Str(esp_signer_gauth_pgm_str_37 /* "client_secret" */), config->internal.client_secret.c_str());
+    // generate RSA or ECDSA signature from private key and message digest
+    size_t len = keyCache.signatureLength();
+    unsigned char *signature = MemoryHelper::createBuffer<unsigned char *>(mbfs, len);
 
-        jsonPtr->add(pgm2Str(esp_signer_gauth_pgm_str_38 /* "grant_type" */), pgm2Str(esp_signer_gauth_pgm_str_10 /* "refresh_token" */));
-        jsonPtr->add(pgm2Str(esp_signer_gauth_pgm_str_18 /* "refresh_token" */), config->internal.refresh_token.c_str());
-    }
+    Utils::idle();
+    int ret = 0;
+    if (keyCache.isEC())
+        ret = keyCache.signEC(writer.getHash(), signature) == len;
     else
     {
-
-        // rfc 7523, JWT Bearer Token Grant Type Profile for OAuth 2.0
-
-        // {"grant_type":"urn:ietf:params:oauth:grant-type:jwt-bearer","assertion":"<signed jwt token>"}
-        jsonPtr->add(pgm2Str(esp_signer_gauth_pgm_str_38 /* "grant_type" */),
-                     pgm2Str(esp_signer_gauth_pgm_str_39 /* "urn:ietf:params:oauth:grant-type:jwt-bearer" */));
-        jsonPtr->add(pgm2Str(esp_signer_gauth_pgm_str_40 /* "assertion" */), config->signer.tokens.jwt.c_str());
+        // the prepared key has one workspace, it belongs to the prefetch task while it is running
+        bool usePrepared = forPrefetch || !prefetchRunning();
+        ret = keyCache.sign(forPrefetch ? prefetch.rsaEngine : config->signer.rsaEngine, BR_HASH_OID_SHA256,
+                            writer.getHash(), br_sha256_SIZE, signature, usePrepared);
     }
+    Utils::idle();
 
-    req += esp_signer_gauth_pgm_str_28; // "/"
-    req += esp_signer_gauth_pgm_str_29; // "token"
-    HttpHelper::addRequestHeaderLast(req);
-    HttpHelper::addGAPIsHostHeader(req, esp_signer_gauth_pgm_str_41 /* "oauth2" */);
+    // get the signed JWT
+    if (ret > 0)
+    {
+        writer.encode(signature, len);
+        writer.encodeEnd();
+    }
 
-    HttpHelper::addUAHeader(req);
-    HttpHelper::addContentLengthHeader(req, strlen(jsonPtr->raw()));
-    HttpHelper::addContentTypeHeader(req, esp_signer_gauth_pgm_str_13 /* "application/json" */);
-    HttpHelper::addNewLine(req);
+    MemoryHelper::freeBuffer(mbfs, signature);
 
-    req += jsonPtr->raw();
+    return ret > 0;
+}
 
-    tcpClient->send(req.c_str());
+void GAuth_OAuth2_Client::writeJWT(GAuth_JWT_Writer &writer, uint32_t now, uint32_t exp, const char *audience)
+{
+    // header
+    // {"alg":"RS256","typ":"JWT"} or {"alg":"ES256","typ":"JWT"}
+    writer.writeHeader(keyCache.isEC() ? esp_signer_gauth_pgm_str_48 : esp_signer_gauth_pgm_str_47);
+
+    // payload, the timestamps are the last claims, the white space aligns them to the Base64 group
+    // {"iss":"<email>","sub":"<email>","aud":"<audience>","scope":"<scope>","iat":<timstamp>,"exp":<expire>}
+    // {"iss":"<email>","sub":"<email>","aud":"<API audience>","iat":<timstamp>,"exp":<expire>}
+    // {"iss":"<email>","sub":"<email>","scope":"<scope>","iat":<timstamp>,"exp":<expire>}
+    writer.encodeClaim(esp_signer_gauth_pgm_str_24 /* "iss" */, config->service_account.data.client_email.c_str(), true);
+    writer.encodeClaim(esp_signer_gauth_pgm_str_25 /* "sub" */, config->service_account.data.client_email.c_str());
+
+    if (!audience)
+    {
+        // "https://oauth2.googleapis.com/token"
+        writer.encodeKey(esp_signer_gauth_pgm_str_30 /* "aud" */);
+        writer.encode('"');
+        writer.encodeP(esp_signer_gauth_pgm_str_26); // "https://"
+        writer.encodeP(esp_signer_gauth_pgm_str_27); // "oauth2"
+        writer.encodeP(esp_signer_pgm_str_2);        // "."
+        writer.encodeP(esp_signer_pgm_str_3);        // "googleapis.com"
+        writer.encodeP(esp_signer_gauth_pgm_str_28); // "/"
+        writer.encodeP(esp_signer_gauth_pgm_str_29); // "token"
+        writer.encode('"');
+    }
+    else if (strlen(audience) > 0)
+        writer.encodeClaim(esp_signer_gauth_pgm_str_30 /* "aud" */, audience);
 
-    req.clear();
+    // the self-signed JWT with audience does not need the scope
+    if (!audience || strlen(audience) == 0)
+    {
+        writer.encodeKey(esp_signer_gauth_pgm_str_33 /* "scope" */);
+        writer.encode('"');
 
-    if (response_code < 0)
-        return handleTaskError(ESP_SIGNER_ERROR_TCP_ERROR_CONNECTION_LOST, response_code);
+        if (config->signer.tokens.scope.length() > 0)
+        {
+            // comma separated scopes to space separated scopes
+            const char *p = config->signer.tokens.scope.c_str();
+            bool first = true;
+            while (*p)
+            {
+                const char *end = strchr(p, ',');
+                size_t n = end ? (size_t)(end - p) : strlen(p);
+                const char *next = p + n;
 
-    struct esp_signer_gauth_auth_token_error_t error;
+                while (n > 0 && isspace(*p))
+                {
+                    p++;
+                    n--;
+                }
+
+                while (n > 0 && isspace(p[n - 1]))
+                    n--;
+
+                if (n > 0)
+                {
+                    if (!first)
+                        writer.encodeP(esp_signer_pgm_str_15); // " "
+                    writer.encodeEscaped(p, n);
+                    first = false;
+                }
+
+                p = end ? next + 1 : next;
+            }
+        }
+        else
+            writer.encodeP(esp_signer_gauth_pgm_str_46); // "https://www.googleapis.com/auth/cloud-platform"
+
+        writer.encode('"');
+    }
+
+    writer.encodeTimestamps(esp_signer_gauth_pgm_str_31 /* "iat" */, now, esp_signer_gauth_pgm_str_32 /* "exp" */, exp);
+
+    writer.encode('}');
+    writer.encodeEnd();
+}
+
+bool GAuth_OAuth2_Client::handleSelfSignedJWT()
+{
+    // the signed JWT is used as the access token, no token exchange needed
+    config->internal.auth_token = jwt.c_str();
+    publishToken();
+    config->signer.tokens.expires = jwtExpires;
+    config->signer.tokens.last_millis = millis();
+    setJWTCache(config->signer.tokens.audience.c_str(), jwt.c_str(), jwtExpires);
+    jwt.clear();
+
+    return handleTaskError(ESP_SIGNER_ERROR_TOKEN_COMPLETE_NOTIFY);
+}
+
+int GAuth_OAuth2_Client::getJWTCacheIndex(const char *audience)
+{
+    for (size_t i = 0; i < jwtCache.size(); i++)
+    {
+        if (strcmp(jwtCache[i].audience.c_str(), audience) == 0)
+            return i;
+    }
+    return -1;
+}
+
+void GAuth_OAuth2_Client::setJWTCache(const char *audience, const char *token, unsigned long expires)
+{
+    int index = getJWTCacheIndex(audience);
+
+    if (index < 0)
+    {
+        // replace the item that expires first when the cache is full
+        if (jwtCache.size() >= ESP_SIGNER_MAX_SELF_SIGNED_JWT_CACHE)
+        {
+            index = 0;
+            for (size_t i = 1; i < jwtCache.size(); i++)
+            {
+                if (jwtCache[i].expires < jwtCache[index].expires)
+                    index = i;
+            }
+        }
+        else
+        {
+            jwtCache.push_back(esp_signer_gauth_jwt_cache_item_t());
+            index = jwtCache.size() - 1;
+        }
+    }
+
+    jwtCache[index].audience = audience;
+    jwtCache[index].token = token;
+    jwtCache[index].expires = expires;
+}
+
+void GAuth_OAuth2_Client::clearJWTCache()
+{
+    for (size_t i = 0; i < jwtCache.size(); i++)
+    {
+        jwtCache[i].audience.clear();
+        jwtCache[i].token.clear();
+    }
+    jwtCache.clear();
+}
+
+String GAuth_OAuth2_Client::getSelfSignedJWT(const char *audience)
+{
+    if (!config || !audience)
+        return String();
+
+    time_t now = getTime();
+
+    int index = getJWTCacheIndex(audience);
+
+    if (index > -1 && now < (time_t)(jwtCache[index].expires - config->signer.preRefreshSeconds))
+        return jwtCache[index].token.c_str();
+
+    // iat and exp claims need the valid time
+    tryGetTime();
+
+    if (!config->internal.clock_rdy || !loadPrivateKey())
+        return String();
+
+    // use the separate buffer, the token processing task may be using the other
+    GAuth_JWT_Writer writer;
+    writer.begin(mbfs);
+
+    unsigned long expires = 0;
+    if (!encodeJWT(writer, audience, nullptr, expires))
+        return String();
+
+    writer.writeP(esp_signer_gauth_pgm_str_35); // "."
+
+    if (!signJWT(writer))
+        return String();
+
+    setJWTCache(audience, writer.c_str(), expires);
+
+    return writer.c_str();
+}
+
+bool GAuth_OAuth2_Client::initClient(PGM_P subDomain, esp_signer_gauth_auth_token_status status, bool &sessionReused)
+{
+
+    Utils::idle();
+
+    if (status != esp_signer_token_status_uninitialized)
+    {
+        config->signer.tokens.status = status;
+        config->internal.processing = true;
+        config->signer.tokens.error.code = 0;
+        config->signer.tokens.error.message.clear();
+        config->internal.last_jwt_generation_error_cb_millis = 0;
+        config->internal.last_request_token_cb_millis = millis();
+        sendTokenStatusCB();
+    }
+
+    MB_String host;
+    HttpHelper::addGAPIsHost(host, subDomain);
+
+    // reuse the kept-alive session to the same host, otherwise stop the TCP session
+    sessionReused = config->signer.keepAlive && tcpClient->sessionAlive(host.c_str(), 443);
+
+    if (!sessionReused)
+    {
+        tcpClient->stop();
+        tcpClient->setCACert(nullptr);
+    }
+
+    if (!reconnect(tcpClient))
+        return false;
+
+    // for the TLS session cache file
+    tcpClient->setConfig(config, mbfs);
+
+    tcpClient->setBufferSizes(2048, 1024);
+
+    Utils::idle();
+    tcpClient->begin(host.c_str(), 443, &response_code);
+
+    return true;
+}
+
+bool GAuth_OAuth2_Client::sendRequest(esp_signer_gauth_token_request_t &r)
+{
+    // The idle kept-alive session may be closed by server at any time,
+    // resend once on the new session when nothing was received from the reused one.
+    while (true)
+    {
+        r.httpCode = ESP_SIGNER_ERROR_HTTP_CODE_REQUEST_TIMEOUT;
+        r.extractor.reset();
+
+        r.sent = tcpClient->send(r.req.c_str()) > 0;
+
+        // the response JSON is parsed while it is read
+        if (r.sent && readResponse(tcpClient, r, !r.keepAlive) && r.extractor.isStarted())
+            return true;
+
+        if (!r.resend || (r.sent && (r.httpCode > 0 || r.extractor.isStarted())))
+            return false;
+
+        r.resend = false;
+        tcpClient->stop();
+    }
+}
+
+bool GAuth_OAuth2_Client::requestTokens(bool refresh)
+{
+    if (!beginTokenRequest(refresh))
+        return false;
+
+    bool received = sendRequest(*tokenRequest);
+
+    return endTokenRequest(received);
+}
+
+bool GAuth_OAuth2_Client::beginTokenRequest(bool refresh)
+{
+    time_t now = getTime();
+
+    if (config->signer.tokens.status == esp_signer_token_status_on_request ||
+        config->signer.tokens.status == esp_signer_token_status_on_refresh ||
+        ((unsigned long)now < ESP_SIGNER_DEFAULT_TS && !refresh) ||
+        config->internal.processing || prefetchRunning())
+        return false;
+
+    bool sessionReused = false;
+    if (!initClient(esp_signer_gauth_pgm_str_36 /* "www" */, refresh ? esp_signer_token_status_on_refresh : esp_signer_token_status_on_request, sessionReused))
+        return false;
+
+    initJson();
+
+    freeTokenRequest();
+    tokenRequest = new esp_signer_gauth_token_request_t();
+    tokenRequest->refresh = refresh;
+    tokenRequest->keepAlive = config->signer.keepAlive;
+    tokenRequest->timeout = serverResponseTimeout();
+
+    MB_String &req = tokenRequest->req;
+    HttpHelper::addRequestHeaderFirst(req, http_post);
+
+    if (refresh)
+    {
+        // {"client_id":"<client id>","client_secret":"<client secret>","grant_type":"refresh_token",
+        // "refresh_token":"<refresh token>"}
+        jsonPtr->add(pgm2Str(esp_signer_gauth_pgm_str_7 /* "client_id" */), config->internal.client_id.c_str());
+        jsonPtr->add(pgm2Str(esp_signer_gauth_pgm_str_37 /* "client_secret" */), config->internal.client_secret.c_str());
+
+        jsonPtr->add(pgm2Str(esp_signer_gauth_pgm_str_38 /* "grant_type" */), pgm2Str(esp_signer_gauth_pgm_str_10 /* "refresh_token" */));
+        jsonPtr->add(pgm2Str(esp_signer_gauth_pgm_str_18 /* "refresh_token" */), config->internal.refresh_token.c_str());
+    }
+    else
+    {
+
+        // rfc 7523, JWT Bearer Token Grant Type Profile for OAuth 2.0
+
+        // {"grant_type":"urn:ietf:params:oauth:grant-type:jwt-bearer","assertion":"<signed jwt token>"}
+        jsonPtr->add(pgm2Str(esp_signer_gauth_pgm_str_38 /* "grant_type" */),
+                     pgm2Str(esp_signer_gauth_pgm_str_39 /* "urn:ietf:params:oauth:grant-type:jwt-bearer" */));
+        jsonPtr->add(pgm2Str(esp_signer_gauth_pgm_str_40 /* "assertion" */), jwt.c_str());
+    }
+
+    req += esp_signer_gauth_pgm_str_28; // "/"
+    req += esp_signer_gauth_pgm_str_29; // "token"
+    HttpHelper::addRequestHeaderLast(req);
+    HttpHelper::addGAPIsHostHeader(req, esp_signer_gauth_pgm_str_41 /* "oauth2" */);
+
+    HttpHelper::addUAHeader(req);
+    HttpHelper::addConnectionHeader(req, config->signer.keepAlive);
+    HttpHelper::addContentLengthHeader(req, strlen(jsonPtr->raw()));
+    HttpHelper::addContentTypeHeader(req, esp_signer_gauth_pgm_str_13 /* "application/json" */);
+    HttpHelper::addNewLine(req);
+
+    req += jsonPtr->raw();
+
+    // the response fields are extracted while the response is read
+    MB_JSON_Extractor &extractor = tokenRequest->extractor;
+    tokenRequest->tokenIdx = extractor.add(esp_signer_gauth_pgm_str_44 /* "access_token" */, &tokenRequest->accessToken);
+    tokenRequest->expiresIdx = extractor.add(esp_signer_gauth_pgm_str_19 /* "expires_in" */, tokenRequest->expiresIn, sizeof(tokenRequest->expiresIn));
+    tokenRequest->errorIdx = extractor.add(esp_signer_gauth_pgm_str_42 /* "error" */);
+    tokenRequest->codeIdx = extractor.add(esp_signer_gauth_pgm_str_14 /* "error/code" */, tokenRequest->errorCode, sizeof(tokenRequest->errorCode));
+    tokenRequest->messageIdx = extractor.add(esp_signer_gauth_pgm_str_15 /* "error/message" */, &tokenRequest->errorMessage);
+    tokenRequest->descriptionIdx = extractor.add(esp_signer_gauth_pgm_str_43 /* "error_description" */, &tokenRequest->errorDescription);
+
+    // the idle kept-alive session may be closed by server, the request can be resent once
+    tokenRequest->resend = sessionReused;
+
+    return true;
+}
+
+bool GAuth_OAuth2_Client::stepTokenRequest(unsigned long budget, bool &done)
+{
+    done = false;
+
+    if (!tokenRequest)
+    {
+        done = true;
+        return false;
+    }
+
+    esp_signer_gauth_token_request_t *r = tokenRequest;
+
+    switch (r->state)
+    {
+    case esp_signer_gauth_request_state_connect:
+
+        // the connection and TLS handshake are one step
+        if (!tcpClient->connected() && !tcpClient->connect())
+        {
+            done = true;
+            return endTokenRequest(false);
+        }
+        r->state = esp_signer_gauth_request_state_send;
+        break;
+
+    case esp_signer_gauth_request_state_send:
+
+        r->httpCode = ESP_SIGNER_ERROR_HTTP_CODE_REQUEST_TIMEOUT;
+        r->retryAfter = -1;
+        r->extractor.reset();
+        r->parser = GAuth_HTTP_Parser(&r->sink);
+
+        tcpClient->send(r->req.c_str());
+        r->sent = response_code >= 0;
+
+        if (!r->sent)
+        {
+            done = true;
+            return endTokenRequest(false);
+        }
+
+        r->dataTime = millis();
+        r->state = esp_signer_gauth_request_state_receive;
+        break;
+
+    case esp_signer_gauth_request_state_receive:
+    {
+        // read the available data until the budget is used
+        unsigned long start = millis();
+
+        while (!r->parser.complete() && !r->parser.error())
+        {
+            Utils::idle();
+
+            if (r->parser.read(tcpClient) > 0)
+                r->dataTime = millis();
+            else if (!tcpClient->connected())
+            {
+                // The session was closed, only the payload without content length can be completed
+                r->parser.end();
+                break;
+            }
+            else if (!reconnect(tcpClient, r->dataTime))
+                break;
+
+            // continue reading in the next call
+            if (!r->parser.complete() && !r->parser.error() && millis() - start >= budget)
+                return false;
+        }
+
+        bool stopSession = !r->keepAlive;
+        if ((stopSession || r->parser.connectionClose || !r->parser.complete()) && tcpClient->connected())
+            tcpClient->stop();
+
+        r->httpCode = r->parser.httpCode;
+        r->retryAfter = r->parser.retryAfter;
+
+        bool received = r->parser.complete() && r->extractor.isStarted();
+
+        // resend once on the new session when nothing was received from the reused one
+        if (!received && r->resend && !(r->httpCode > 0 || r->extractor.isStarted()))
+        {
+            r->resend = false;
+            tcpClient->stop();
+            response_code = 0;
+            r->state = esp_signer_gauth_request_state_connect;
+            return false;
+        }
+
+        done = true;
+        return endTokenRequest(received);
+    }
+
+    default:
+        break;
+    }
+
+    return false;
+}
+
+void GAuth_OAuth2_Client::freeTokenRequest()
+{
+    if (tokenRequest)
+    {
+        tokenRequest->req.clear();
+        delete tokenRequest;
+    }
+    tokenRequest = nullptr;
+}
+
+bool GAuth_OAuth2_Client::endTokenRequest(bool received)
+{
+    if (!tokenRequest)
+        return false;
+
+    esp_signer_gauth_token_request_t *r = tokenRequest;
+    int httpCode = r->httpCode;
+    int retryAfter = r->retryAfter;
+
+    r->req.clear();
+
+    if (!r->sent)
+    {
+        freeTokenRequest();
+        setRequestResult(false, retryAfter);
+        return handleTaskError(ESP_SIGNER_ERROR_TCP_ERROR_CONNECTION_LOST, response_code);
+    }
 
-    int httpCode = ESP_SIGNER_ERROR_HTTP_CODE_REQUEST_TIMEOUT;
-    MB_String payload;
-    if (handleResponse(tcpClient, httpCode, payload))
+    if (received)
     {
-        config->signer.tokens.jwt.clear();
-        if (JsonHelper::parse(jsonPtr, resultPtr, esp_signer_gauth_pgm_str_14 /* "error/code" */))
+        struct esp_signer_gauth_auth_token_error_t error;
+
+        jwt.clear();
+        if (r->extractor.found(r->codeIdx))
         {
-            error.code = resultPtr->to<int>();
+            error.code = atoi(r->errorCode);
             config->signer.tokens.status = esp_signer_token_status_error;
 
-            if (JsonHelper::parse(jsonPtr, resultPtr, esp_signer_gauth_pgm_str_15 /* "error/message" */))
-                error.message = resultPtr->to<const char *>();
+            if (r->extractor.found(r->messageIdx))
+                error.message = r->errorMessage;
         }
-        else if (JsonHelper::parse(jsonPtr, resultPtr, esp_signer_gauth_pgm_str_42 /* "error" */))
+        else if (r->extractor.found(r->errorIdx))
         {
             error.code = -1;
             config->signer.tokens.status = esp_signer_token_status_error;
 
-            if (JsonHelper::parse(jsonPtr, resultPtr, esp_signer_gauth_pgm_str_43 /* "error_description" */))
-                error.message = resultPtr->to<const char *>();
+            if (r->extractor.found(r->descriptionIdx))
+                error.message = r->errorDescription;
         }
 
         if (error.code != 0)
@@ -1107,20 +1578,42 @@ bool GAuth_OAuth2_Client::requestTokens(bool refresh)
         if (error.code == 0)
         {
 
-            if (JsonHelper::parse(jsonPtr, resultPtr, esp_signer_gauth_pgm_str_44 /* "access_token" */))
-                config->internal.auth_token = resultPtr->to<const char *>();
+            if (r->extractor.found(r->tokenIdx))
+            {
+                config->internal.auth_token = r->accessToken;
+                publishToken();
+            }
+
+            if (r->extractor.found(r->expiresIdx))
+                getExpiration(r->expiresIn);
 
-            if (JsonHelper::parse(jsonPtr, resultPtr, esp_signer_gauth_pgm_str_19 /* "expires_in" */))
-                getExpiration(resultPtr->to<const char *>());
+            if (!r->refresh)
+                saveToken();
 
+            freeTokenRequest();
+            setRequestResult(true);
             return handleTaskError(ESP_SIGNER_ERROR_TOKEN_COMPLETE_NOTIFY);
         }
+
+        freeTokenRequest();
+        setRequestResult(false, retryAfter);
         return handleTaskError(ESP_SIGNER_ERROR_TOKEN_ERROR_UNNOTIFY);
     }
 
+    freeTokenRequest();
+    setRequestResult(false, retryAfter);
     return handleTaskError(ESP_SIGNER_ERROR_HTTP_CODE_REQUEST_TIMEOUT, httpCode);
 }
 
+void GAuth_OAuth2_Client::setRequestResult(bool success, int retryAfter)
+{
+    if (success)
+        scheduler.succeeded();
+    else
+        scheduler.failed(config->timeout.tokenRequestRetry, config->timeout.tokenRequestRetryMax,
+                         retryAfter > 0 ? (unsigned long)retryAfter * 1000 : 0);
+}
+
 void GAuth_OAuth2_Client::getExpiration(const char *exp)
 {
     time_t now = getTime();
@@ -1129,13 +1622,246 @@ void GAuth_OAuth2_Client::getExpiration(const char *exp)
     config->signer.tokens.last_millis = ms;
 }
 
+bool GAuth_OAuth2_Client::exchangeJWT(esp_signer_gauth_prefetch_t &pf)
+{
+    // the token status and config are not changed, the current token is still in use
+    esp_signer_gauth_token_request_t r;
+    r.keepAlive = pf.keepAlive;
+    r.timeout = pf.timeout;
+
+    MB_String host;
+    HttpHelper::addGAPIsHost(host, esp_signer_gauth_pgm_str_36 /* "www" */);
+
+    // reuse the kept-alive session to the same host, otherwise stop the TCP session
+    r.resend = pf.keepAlive && tcpClient->sessionAlive(host.c_str(), 443);
+
+    if (!r.resend)
+    {
+        tcpClient->stop();
+        tcpClient->setCACert(nullptr);
+    }
+
+    // the network is reconnected by the token request on the user task
+    if (!tcpClient->networkReady())
+    {
+        pf.responseCode = ESP_SIGNER_ERROR_TCP_ERROR_CONNECTION_LOST;
+        tcpClient->stop();
+        return false;
+    }
+
+    tcpClient->setBufferSizes(2048, 1024);
+
+    Utils::idle();
+    tcpClient->begin(host.c_str(), 443, &pf.responseCode);
+
+    FirebaseJson json;
+    json.add(pgm2Str(esp_signer_gauth_pgm_str_38 /* "grant_type" */),
+             pgm2Str(esp_signer_gauth_pgm_str_39 /* "urn:ietf:params:oauth:grant-type:jwt-bearer" */));
+    json.add(pgm2Str(esp_signer_gauth_pgm_str_40 /* "assertion" */), pf.jwt.c_str());
+
+    MB_String &req = r.req;
+    HttpHelper::addRequestHeaderFirst(req, http_post);
+    req += esp_signer_gauth_pgm_str_28; // "/"
+    req += esp_signer_gauth_pgm_str_29; // "token"
+    HttpHelper::addRequestHeaderLast(req);
+    HttpHelper::addGAPIsHostHeader(req, esp_signer_gauth_pgm_str_41 /* "oauth2" */);
+
+    HttpHelper::addUAHeader(req);
+    HttpHelper::addConnectionHeader(req, pf.keepAlive);
+    HttpHelper::addContentLengthHeader(req, strlen(json.raw()));
+    HttpHelper::addContentTypeHeader(req, esp_signer_gauth_pgm_str_13 /* "application/json" */);
+    HttpHelper::addNewLine(req);
+
+    req += json.raw();
+    json.clear();
+
+    r.tokenIdx = r.extractor.add(esp_signer_gauth_pgm_str_44 /* "access_token" */, &pf.token);
+    r.expiresIdx = r.extractor.add(esp_signer_gauth_pgm_str_19 /* "expires_in" */, r.expiresIn, sizeof(r.expiresIn));
+
+    bool received = sendRequest(r);
+
+    req.clear();
+
+    bool ret = received && r.extractor.found(r.tokenIdx) && r.extractor.found(r.expiresIdx) && pf.token.length() > 0;
+    pf.expiresIn = ret ? atoi(r.expiresIn) : 0;
+    pf.retryAfter = r.retryAfter;
+
+    if (!ret || !pf.keepAlive)
+        tcpClient->stop();
+
+    return ret;
+}
+
+void GAuth_OAuth2_Client::runPrefetch()
+{
+    // only the prefetch slot is written here, the outcome is published by checkPrefetch
+    bool ret = signJWT(prefetch.jwt, true) && exchangeJWT(prefetch);
+
+    prefetch.jwt.clear();
+
+    if (!ret)
+        prefetch.token.clear();
+
+    // the outcome should be visible before the state
+    __sync_synchronize();
+    prefetchState = ret ? esp_signer_gauth_prefetch_state_done : esp_signer_gauth_prefetch_state_failed;
+}
+
+#if defined(ESP32)
+void GAuth_OAuth2_Client::prefetchTask(void *param)
+{
+    reinterpret_cast<GAuth_OAuth2_Client *>(param)->runPrefetch();
+    vTaskDelete(NULL);
+}
+#endif
+
+void GAuth_OAuth2_Client::checkPrefetch()
+{
+    if (!config)
+        return;
+
+    if (prefetchState == esp_signer_gauth_prefetch_state_done)
+    {
+        __sync_synchronize();
+        prefetchState = esp_signer_gauth_prefetch_state_idle;
+        setRequestResult(true);
+
+        // the token was reset while it was requested
+        if (config->signer.tokens.status != esp_signer_token_status_ready)
+        {
+            prefetch.token.clear();
+            return;
+        }
+
+        // swap in the new token, the old token is released with the prefetch buffer
+        config->internal.auth_token.swap(prefetch.token);
+        prefetch.token.clear();
+        publishToken();
+        config->signer.tokens.expires = getTime() + prefetch.expiresIn;
+        config->signer.tokens.last_millis = millis();
+        config->signer.lastReqMillis = millis();
+        saveToken();
+        sendTokenStatusCB();
+        return;
+    }
+
+    if (prefetchState == esp_signer_gauth_prefetch_state_failed)
+    {
+        // retry after the backoff delay, the token will be requested as usual when it expires
+        __sync_synchronize();
+        prefetchState = esp_signer_gauth_prefetch_state_idle;
+        setRequestResult(false, prefetch.retryAfter);
+        return;
+    }
+
+    if (prefetchState != esp_signer_gauth_prefetch_state_idle ||
+        config->signer.prefetchSeconds <= config->signer.preRefreshSeconds ||
+        config->signer.tokens.token_type != token_type_oauth2_access_token ||
+        config->signer.tokens.status != esp_signer_token_status_ready ||
+        config->signer.tokens.expires == 0 || config->internal.processing || !keyCache.ready())
+        return;
+
+    time_t now = getTime();
+
+    if ((unsigned long)now < ESP_SIGNER_DEFAULT_TS ||
+        now <= (time_t)(config->signer.tokens.expires - config->signer.prefetchSeconds) || isExpired())
+        return;
+
+    // the request interval grows after the failed requests
+    if (lastPrefetchMillis > 0 && millis() - lastPrefetchMillis < scheduler.retryDelay(config->signer.reqTO))
+        return;
+
+    lastPrefetchMillis = millis();
+
+    // the key is prepared here, the prefetch task only reads the key cache
+    keyCache.prepare(config->signer.rsaEngine);
+
+    // the task inputs are copied and the JWT is encoded here, the task does not read the config
+    prefetch.rsaEngine = config->signer.rsaEngine;
+    prefetch.keepAlive = config->signer.keepAlive;
+    prefetch.timeout = serverResponseTimeout();
+    prefetch.token.clear();
+    prefetch.expiresIn = 0;
+    prefetch.retryAfter = -1;
+    prefetch.responseCode = 0;
+
+    // the JWT expiry is not used, the exchanged token has its own expiry
+    unsigned long jwtExp = 0;
+
+    if (!encodeJWT(prefetch.jwt, nullptr, &prefetchTemplate, jwtExp))
+    {
+        prefetch.jwt.clear();
+        setRequestResult(false);
+        return;
+    }
+
+    prefetch.jwt.writeP(esp_signer_gauth_pgm_str_35); // "."
+
+    prefetchState = esp_signer_gauth_prefetch_state_running;
+
+#if defined(ESP32)
+    // the shared client may be used by other tokens at the same time
+    if (!sharedTCPClient &&
+        xTaskCreate(prefetchTask, "prefetchTask", ESP_SIGNER_PREFETCH_TASK_STACK_SIZE, this,
+                    ESP_SIGNER_PREFETCH_TASK_PRIORITY, NULL) == pdPASS)
+        return;
+#endif
+
+    runPrefetch();
+}
+
 void GAuth_OAuth2_Client::checkToken()
 {
     if (!config)
         return;
 
+    checkPrefetch();
+
     if (isExpired())
         handleToken();
+
+    notifyWaiters();
+}
+
+bool GAuth_OAuth2_Client::requestTokenAsync(TokenRequestCallback callback, void *arg)
+{
+    if (!config || !callback)
+        return false;
+
+    esp_signer_gauth_token_waiter_t waiter;
+    waiter.callback = callback;
+    waiter.arg = arg;
+    waiters.push_back(waiter);
+
+    // the ready token is delivered at once, otherwise tokenReady() sends the request and delivers its result,
+    // the shared TCP client may be in use by the other token request here
+    notifyWaiters();
+
+    return true;
+}
+
+void GAuth_OAuth2_Client::notifyWaiters()
+{
+    if (!config || waiters.size() == 0)
+        return;
+
+    bool ready = config->signer.tokens.status == esp_signer_token_status_ready;
+    bool failed = config->signer.tokens.status == esp_signer_token_status_error && !config->internal.processing;
+
+    if (!ready && !failed)
+        return;
+
+    TokenInfo info;
+    info.type = config->signer.tokens.token_type;
+    info.status = config->signer.tokens.status;
+    info.error = config->signer.tokens.error;
+
+    // the callback may request the token again, it will wait for the next delivery
+    MB_VECTOR<esp_signer_gauth_token_waiter_t> list;
+    list.swap(waiters);
+
+    for (size_t i = 0; i < list.size(); i++)
+        list[i].callback(info, ready ? config->internal.auth_token.c_str() : "", list[i].arg);
 }
 
 bool GAuth_OAuth2_Client::tokenReady()
@@ -1145,6 +1871,14 @@ bool GAuth_OAuth2_Client::tokenReady()
 
     checkToken();
 
+    // the self-signed JWT is created locally, no network connection required
+    if (config->signer.tokens.token_type == token_type_self_signed_jwt)
+        return config->signer.tokens.status == esp_signer_token_status_ready;
+
+    // the prefetch task is using the connection, the current token is still valid
+    if (prefetchRunning())
+        return config->signer.tokens.status == esp_signer_token_status_ready;
+
     // call checkToken to send callback before checking connection.
     if (!reconnect())
         return false;
@@ -1152,65 +1886,63 @@ bool GAuth_OAuth2_Client::tokenReady()
     return config->signer.tokens.status == esp_signer_token_status_ready;
 };
 
-String GAuth_OAuth2_Client::getTokenType(TokenInfo info)
+const __FlashStringHelper *GAuth_OAuth2_Client::tokenTypeString(esp_signer_gauth_auth_token_type type)
 {
-    if (!config)
-        return String();
-
-    MB_String s;
-    switch (info.type)
+    switch (type)
     {
     case token_type_undefined:
-        s = esp_signer_pgm_str_39;
-        break;
+        return FPSTR(esp_signer_pgm_str_39);
     case token_type_oauth2_access_token:
-        s = esp_signer_pgm_str_40;
-        break;
+        return FPSTR(esp_signer_pgm_str_40);
+    case token_type_self_signed_jwt:
+        return FPSTR(esp_signer_pgm_str_50);
     default:
-        break;
+        return F("");
     }
-    return s.c_str();
 }
 
-String GAuth_OAuth2_Client::getTokenType()
+const __FlashStringHelper *GAuth_OAuth2_Client::tokenStatusString(esp_signer_gauth_auth_token_status status)
 {
-    return getTokenType(tokenInfo);
-}
-
-String GAuth_OAuth2_Client::getTokenStatus(TokenInfo info)
-{
-    if (!config)
-        return String();
-
-    MB_String s;
-    switch (info.status)
+    switch (status)
     {
     case esp_signer_token_status_uninitialized:
-        s = esp_signer_pgm_str_41;
-        break;
-
+        return FPSTR(esp_signer_pgm_str_41);
     case esp_signer_token_status_on_initialize:
-        s = esp_signer_pgm_str_42;
-        break;
+        return FPSTR(esp_signer_pgm_str_42);
     case esp_signer_token_status_on_signing:
-        s = esp_signer_pgm_str_43;
-        break;
+        return FPSTR(esp_signer_pgm_str_43);
     case esp_signer_token_status_on_request:
-        s = esp_signer_pgm_str_44;
-        break;
+        return FPSTR(esp_signer_pgm_str_44);
     case esp_signer_token_status_on_refresh:
-        s = esp_signer_pgm_str_45;
-        break;
+        return FPSTR(esp_signer_pgm_str_45);
     case esp_signer_token_status_ready:
-        s = esp_signer_pgm_str_49;
-        break;
+        return FPSTR(esp_signer_pgm_str_49);
     case esp_signer_token_status_error:
-        s = esp_signer_pgm_str_46;
-        break;
+        return FPSTR(esp_signer_pgm_str_46);
     default:
-        break;
+        return F("");
     }
-    return s.c_str();
+}
+
+String GAuth_OAuth2_Client::getTokenType(TokenInfo info)
+{
+    if (!config)
+        return String();
+
+    return String(tokenTypeString(info.type));
+}
+
+String GAuth_OAuth2_Client::getTokenType()
+{
+    return getTokenType(tokenInfo);
+}
+
+String GAuth_OAuth2_Client::getTokenStatus(TokenInfo info)
+{
+    if (!config)
+        return String();
+
+    return String(tokenStatusString(info.status));
 }
 
 String GAuth_OAuth2_Client::getTokenStatus()
@@ -1237,11 +1969,23 @@ void GAuth_OAuth2_Client::reset()
         config->internal.client_id.clear();
         config->internal.client_secret.clear();
         config->internal.auth_token.clear();
+        publishToken();
         config->internal.refresh_token.clear();
         config->signer.lastReqMillis = 0;
         config->internal.last_jwt_generation_error_cb_millis = 0;
         config->signer.tokens.expires = 0;
         config->internal.rtoken_requested = false;
+        clearJWTCache();
+
+        // cancel the token request in progress
+        if (tokenRequest)
+        {
+            freeTokenRequest();
+            tcpClient->stop();
+            freeJson();
+            config->internal.processing = false;
+            config->signer.step = esp_signer_gauth_jwt_generation_step_begin;
+        }
 
         config->internal.client_email_crc = 0;
         config->internal.project_id_crc = 0;
@@ -1283,6 +2027,15 @@ unsigned long GAuth_OAuth2_Client::getExpiredTimestamp()
     return config->signer.tokens.expires;
 }
 
+unsigned long GAuth_OAuth2_Client::serverResponseTimeout()
+{
+    if (config->timeout.serverResponse < ESP_SIGNER_MIN_SERVER_RESPONSE_TIMEOUT ||
+        config->timeout.serverResponse > ESP_SIGNER_MAX_SERVER_RESPONSE_TIMEOUT)
+        config->timeout.serverResponse = ESP_SIGNER_DEFAULT_SERVER_RESPONSE_TIMEOUT;
+
+    return config->timeout.serverResponse;
+}
+
 bool GAuth_OAuth2_Client::reconnect(GAuth_TCP_Client *client, unsigned long dataTime)
 {
     if (!client)
@@ -1290,14 +2043,7 @@ bool GAuth_OAuth2_Client::reconnect(GAuth_TCP_Client *client, unsigned long data
 
     if (dataTime > 0)
     {
-        unsigned long tmo = ESP_SIGNER_DEFAULT_SERVER_RESPONSE_TIMEOUT;
-        if (config->timeout.serverResponse < ESP_SIGNER_MIN_SERVER_RESPONSE_TIMEOUT ||
-            config->timeout.serverResponse > ESP_SIGNER_MAX_SERVER_RESPONSE_TIMEOUT)
-            config->timeout.serverResponse = ESP_SIGNER_DEFAULT_SERVER_RESPONSE_TIMEOUT;
-
-        tmo = config->timeout.serverResponse;
-
-        if (millis() - dataTime > tmo)
+        if (millis() - dataTime > serverResponseTimeout())
         {
             response_code = ESP_SIGNER_ERROR_TCP_RESPONSE_PAYLOAD_READ_TIMED_OUT;
             return false;
@@ -1357,165 +2103,121 @@ void GAuth_OAuth2_Client::errorToString(int httpCode, MB_String &buff)
         return;
     }
 
+    buff += errorString(httpCode);
+}
+
+const __FlashStringHelper *GAuth_OAuth2_Client::errorString(int httpCode)
+{
     switch (httpCode)
     {
     case ESP_SIGNER_ERROR_TCP_ERROR_CONNECTION_REFUSED:
-        buff += F("connection refused");
-        return;
+        return F("connection refused");
     case ESP_SIGNER_ERROR_TCP_ERROR_SEND_REQUEST_FAILED:
-        buff += F("send request failed");
-        return;
+        return F("send request failed");
     case ESP_SIGNER_ERROR_TCP_ERROR_NOT_CONNECTED:
-        buff += F("not connected");
-        return;
+        return F("not connected");
     case ESP_SIGNER_ERROR_TCP_ERROR_CONNECTION_LOST:
-        buff += F("connection lost");
-        return;
+        return F("connection lost");
     case ESP_SIGNER_ERROR_TCP_ERROR_NO_HTTP_SERVER:
-        buff += F("no HTTP server");
-        return;
+        return F("no HTTP server");
     case ESP_SIGNER_ERROR_TCP_CLIENT_MISSING_NETWORK_CONNECTION_CB:
-        buff += F("network connection callback is required");
-        return;
+        return F("network connection callback is required");
     case ESP_SIGNER_ERROR_TCP_CLIENT_MISSING_NETWORK_STATUS_CB:
-        buff += F("network connection status callback is required");
-        return;
+        return F("network connection status callback is required");
     case ESP_SIGNER_ERROR_TCP_CLIENT_NOT_INITIALIZED:
-        buff += F("client and/or necessary callback functions are not yet assigned");
-        return;
+        return F("client and/or necessary callback functions are not yet assigned");
 
     case ESP_SIGNER_ERROR_HTTP_CODE_BAD_REQUEST:
-        buff += F("bad request");
-        return;
+        return F("bad request");
     case ESP_SIGNER_ERROR_HTTP_CODE_NON_AUTHORITATIVE_INFORMATION:
-        buff += F("non-authoriative information");
-        return;
+        return F("non-authoriative information");
     case ESP_SIGNER_ERROR_HTTP_CODE_NO_CONTENT:
-        buff += F("no content");
-        return;
+        return F("no content");
     case ESP_SIGNER_ERROR_HTTP_CODE_MOVED_PERMANENTLY:
-        buff += F("moved permanently");
-        return;
+        return F("moved permanently");
     case ESP_SIGNER_ERROR_HTTP_CODE_USE_PROXY:
-        buff += F("use proxy");
-        return;
+        return F("use proxy");
     case ESP_SIGNER_ERROR_HTTP_CODE_TEMPORARY_REDIRECT:
-        buff += F("temporary redirect");
-        return;
+        return F("temporary redirect");
     case ESP_SIGNER_ERROR_HTTP_CODE_PERMANENT_REDIRECT:
-        buff += F("permanent redirect");
-        return;
+        return F("permanent redirect");
     case ESP_SIGNER_ERROR_HTTP_CODE_UNAUTHORIZED:
-        buff += F("unauthorized");
-        return;
+        return F("unauthorized");
     case ESP_SIGNER_ERROR_HTTP_CODE_FORBIDDEN:
-        buff += F("forbidden");
-        return;
+        return F("forbidden");
     case ESP_SIGNER_ERROR_HTTP_CODE_NOT_FOUND:
-        buff += F("not found");
-        return;
+        return F("not found");
     case ESP_SIGNER_ERROR_HTTP_CODE_METHOD_NOT_ALLOWED:
-        buff += F("method not allow");
-        return;
+        return F("method not allow");
     case ESP_SIGNER_ERROR_HTTP_CODE_NOT_ACCEPTABLE:
-        buff += F("not acceptable");
-        return;
+        return F("not acceptable");
     case ESP_SIGNER_ERROR_HTTP_CODE_PROXY_AUTHENTICATION_REQUIRED:
-        buff += F("proxy authentication required");
-        return;
+        return F("proxy authentication required");
     case ESP_SIGNER_ERROR_HTTP_CODE_REQUEST_TIMEOUT:
-        buff += F("request timed out");
-        return;
+        return F("request timed out");
     case ESP_SIGNER_ERROR_HTTP_CODE_LENGTH_REQUIRED:
-        buff += F("length required");
-        return;
+        return F("length required");
     case ESP_SIGNER_ERROR_HTTP_CODE_TOO_MANY_REQUESTS:
-        buff += F("too many requests");
-        return;
+        return F("too many requests");
     case ESP_SIGNER_ERROR_HTTP_CODE_REQUEST_HEADER_FIELDS_TOO_LARGE:
-        buff += F("request header fields too larg");
-        return;
+        return F("request header fields too larg");
     case ESP_SIGNER_ERROR_HTTP_CODE_INTERNAL_SERVER_ERROR:
-        buff += F("internal server error");
-        return;
+        return F("internal server error");
     case ESP_SIGNER_ERROR_HTTP_CODE_BAD_GATEWAY:
-        buff += F("bad gateway");
-        return;
+        return F("bad gateway");
     case ESP_SIGNER_ERROR_HTTP_CODE_SERVICE_UNAVAILABLE:
-        buff += F("service unavailable");
-        return;
+        return F("service unavailable");
     case ESP_SIGNER_ERROR_HTTP_CODE_GATEWAY_TIMEOUT:
-        buff += F("gateway timeout");
-        return;
+        return F("gateway timeout");
     case ESP_SIGNER_ERROR_HTTP_CODE_HTTP_VERSION_NOT_SUPPORTED:
-        buff += F("http version not support");
-        return;
+        return F("http version not support");
     case ESP_SIGNER_ERROR_HTTP_CODE_NETWORK_AUTHENTICATION_REQUIRED:
-        buff += F("network authentication required");
-        return;
+        return F("network authentication required");
     case ESP_SIGNER_ERROR_HTTP_CODE_PRECONDITION_FAILED:
-        buff += F("Precondition Failed (ETag does not match)");
-        return;
+        return F("Precondition Failed (ETag does not match)");
     case ESP_SIGNER_ERROR_TCP_RESPONSE_PAYLOAD_READ_TIMED_OUT:
-        buff += F("response read timed out");
-        return;
+        return F("response read timed out");
     case ESP_SIGNER_ERROR_TCP_RESPONSE_READ_FAILED:
-        buff += F("Response read failed.");
-        return;
+        return F("Response read failed.");
     case ESP_SIGNER_ERROR_TOKEN_NOT_READY:
-        buff += F("token is not ready (revoked or expired)");
-        return;
+        return F("token is not ready (revoked or expired)");
     case ESP_SIGNER_ERROR_TOKEN_SET_TIME:
-        buff += F("system time was not set");
-        break;
+        return F("system time was not set");
     case ESP_SIGNER_ERROR_TOKEN_PARSE_PK:
-        buff += F("RSA private key parsing failed");
-        break;
+        return F("RSA private key parsing failed");
     case ESP_SIGNER_ERROR_TOKEN_SIGN:
-        buff += F("JWT token signing failed");
-        break;
+        return F("JWT token signing failed");
     case ESP_SIGNER_ERROR_TOKEN_EXCHANGE:
-        buff += F("token exchange failed");
-        break;
+        return F("token exchange failed");
 
 #if defined(MBFS_FLASH_FS) || defined(MBFS_SD_FS)
 
     case MB_FS_ERROR_FLASH_STORAGE_IS_NOT_READY:
-        buff += F("Flash Storage is not ready.");
-        return;
+        return F("Flash Storage is not ready.");
 
     case MB_FS_ERROR_SD_STORAGE_IS_NOT_READY:
-        buff += F("SD Storage is not ready.");
-        return;
+        return F("SD Storage is not ready.");
 
     case MB_FS_ERROR_FILE_STILL_OPENED:
-        buff += F("File is still opened.");
-        return;
+        return F("File is still opened.");
 
     case MB_FS_ERROR_FILE_NOT_FOUND:
-        buff += F("File not found.");
-        return;
+        return F("File not found.");
 #endif
 
     case ESP_SIGNER_ERROR_NTP_SYNC_TIMED_OUT:
-        buff += F("NTP server time synching failed.");
-        return;
+        return F("NTP server time synching failed.");
     case ESP_SIGNER_ERROR_SYS_TIME_IS_NOT_READY:
-        buff += F("System time or library reference time was not set. Use Signer.setSystemTime to set time.");
-        return;
+        return F("System time or library reference time was not set. Use Signer.setSystemTime to set time.");
     case ESP_SIGNER_ERROR_EXTERNAL_CLIENT_NOT_INITIALIZED:
-        buff += F("External client is not yet initialized.");
-        return;
+        return F("External client is not yet initialized.");
 
     case ESP_SIGNER_ERROR_MISSING_SERVICE_ACCOUNT_CREDENTIALS:
-        buff += F("The Service Account Credentials are missing.");
-        return;
+        return F("The Service Account Credentials are missing.");
     case ESP_SIGNER_ERROR_SERVICE_ACCOUNT_JSON_FILE_PARSING_ERROR:
-        buff += F("Unable to parse Service Account JSON file. Please check file name, storage type and its content.");
-        return;
+        return F("Unable to parse Service Account JSON file. Please check file name, storage type and its content.");
     default:
-        buff += F("unknown error");
-        return;
+        return F("unknown error");
     }
 }
 
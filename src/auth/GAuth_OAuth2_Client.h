@@ -38,11 +38,63 @@
 
 #include "mbfs/MB_FS.h"
 #include "client/GAuth_TCP_Client.h"
+#include "client/GAuth_HTTP_Parser.h"
 #include "ESP_Signer_Const.h"
+#include "GAuth_Key_Cache.h"
+#include "GAuth_JWT_Writer.h"
+#include "GAuth_JWT_Template.h"
+#include "GAuth_Token_Store.h"
+#include "GAuth_Refresh_Scheduler.h"
+#include "GAuth_Token_Slot.h"
+
+/* The token request that is sent and read in steps */
+struct esp_signer_gauth_token_request_t
+{
+    esp_signer_gauth_token_request_t() : sink(extractor), parser(&sink){};
+
+    uint8_t state = esp_signer_gauth_request_state_connect;
+    bool refresh = false;
+    MB_String req;
+    /* the response fields */
+    MB_String accessToken, errorMessage, errorDescription;
+    char expiresIn[12];
+    char errorCode[12];
+    MB_JSON_Extractor extractor;
+    int tokenIdx = -1, expiresIdx = -1, errorIdx = -1, codeIdx = -1, messageIdx = -1, descriptionIdx = -1;
+    GAuth_HTTP_JSON_Sink sink;
+    GAuth_HTTP_Parser parser;
+    unsigned long dataTime = 0;
+    int httpCode = ESP_SIGNER_ERROR_HTTP_CODE_REQUEST_TIMEOUT;
+    bool sent = false;
+    /* the kept-alive session was reused, the request can be resent once on the new session */
+    bool resend = false;
+    /* the Retry-After seconds of the response, -1 when not set */
+    int retryAfter = -1;
+    /* the keep-alive option and response timeout of the request, copied from the config */
+    bool keepAlive = false;
+    unsigned long timeout = ESP_SIGNER_DEFAULT_SERVER_RESPONSE_TIMEOUT;
+};
+
+/* The prefetch inputs that are copied before the prefetch task starts and the outcome that only the task writes */
+struct esp_signer_gauth_prefetch_t
+{
+    esp_signer_rsa_engine rsaEngine = esp_signer_rsa_engine_auto;
+    bool keepAlive = false;
+    unsigned long timeout = ESP_SIGNER_DEFAULT_SERVER_RESPONSE_TIMEOUT;
+    /* the encoded JWT header and payload, the task appends the signature */
+    GAuth_JWT_Writer jwt;
+    MB_String token;
+    unsigned long expiresIn = 0;
+    /* the Retry-After seconds of the response, -1 when not set */
+    int retryAfter = -1;
+    /* the TCP client error code of the prefetch request */
+    int responseCode = 0;
+};
 
 class GAuth_OAuth2_Client
 {
     friend class ESP_Signer;
+    friend class GAuth_Token_Manager;
 
 public:
     GAuth_OAuth2_Client();
@@ -51,6 +103,8 @@ public:
 private:
     GAuth_TCP_Client *tcpClient = nullptr;
     bool localTCPClient = false;
+    /* the TCP client is owned by other (token manager entries) */
+    bool sharedTCPClient = false;
     esp_signer_gauth_cfg_t *config = nullptr;
     MB_FS *mbfs = nullptr;
     uint32_t *mb_ts = nullptr;
@@ -60,10 +114,33 @@ private:
     callback_function_t esp8266_cb = nullptr;
 #endif
     TokenInfo tokenInfo;
+    GAuth_Key_Cache keyCache;
+    GAuth_JWT_Writer jwt;
+    /* the encoded JWT of the last token request, only the timestamps are rewritten at the next request */
+    GAuth_JWT_Template jwtTemplate;
+    /* the exp claim of the last encoded JWT */
+    unsigned long jwtExpires = 0;
+    /* the next access token that is signed and exchanged before the current token expires */
+    esp_signer_gauth_prefetch_t prefetch;
+    /* the prefetch JWT has its own template, the token request may encode the JWT before the prefetch finished */
+    GAuth_JWT_Template prefetchTemplate;
+    volatile uint8_t prefetchState = esp_signer_gauth_prefetch_state_idle;
+    unsigned long lastPrefetchMillis = 0;
+    /* the published access token for the readers on other tasks */
+    GAuth_Token_Slot tokenSlot;
+    /* the refresh jitter and retry backoff */
+    GAuth_Refresh_Scheduler scheduler;
+    /* the access token file for reuse after restart */
+    GAuth_Token_Store tokenStore;
+    /* the callbacks that wait for the token in progress */
+    MB_VECTOR<esp_signer_gauth_token_waiter_t> waiters;
+    /* the self-signed JWTs by audience */
+    MB_VECTOR<esp_signer_gauth_jwt_cache_item_t> jwtCache;
     bool _token_processing_task_enable = false;
     FirebaseJson *jsonPtr = nullptr;
-    FirebaseJsonData *resultPtr = nullptr;
     int response_code = 0;
+    /* the token request in progress */
+    esp_signer_gauth_token_request_t *tokenRequest = nullptr;
     time_t ts = 0;
     bool autoReconnectWiFi = true;
     unsigned long last_reconnect_millis = 0;
@@ -86,6 +163,8 @@ private:
     void freeClient(GAuth_TCP_Client **client);
     /* parse service account json file for private key */
     bool parseSAFile();
+    /* decode the private key into the key cache */
+    bool loadPrivateKey();
     /* clear service account credentials */
     void clearServiceAccountCreds();
     /* check for sevice account credentials */
@@ -98,6 +177,10 @@ private:
     bool readyToRequest();
     /* is the time to refresh the token */
     bool readyToRefresh();
+    /* the ms to wait before the next token request, 0 when it can be sent */
+    unsigned long refreshWait();
+    /* the refresh jitter seconds, not more than half of the token lifetime */
+    unsigned long refreshJitter();
     /* is the time to sync clock */
     bool readyToSync();
     /* time synching timed out */
@@ -106,6 +189,12 @@ private:
     bool isErrorCBTimeOut();
     /* handle the auth tokens generation */
     bool handleToken();
+    /* use the saved access token when it is still valid */
+    bool restoreToken();
+    /* save the access token to the token cache file */
+    void saveToken();
+    /* publish the access token to the token view */
+    void publishToken();
     /* init the temp use Json objects */
     void initJson();
     /* free the temp use Json objects */
@@ -116,18 +205,65 @@ private:
     void setTokenError(int code);
     /* handle the token processing task error */
     bool handleTaskError(int code, int httpCode = 0);
-    // parse the auth token response
-    bool handleResponse(GAuth_TCP_Client *client, int &httpCode, MB_String &payload, bool stopSession = true);
+    /* read the response and pass its payload to the sink, the config is not used */
+    bool readResponse(GAuth_TCP_Client *client, esp_signer_gauth_token_request_t &r, bool stopSession = true);
     /* Get time */
     void tryGetTime();
     /* process the tokens (generation, signing, request and refresh) */
     void tokenProcessingTask();
     /* encode and sign the JWT token */
     bool createJWT();
+    /* encode the JWT header and payload and create its message digest,
+    the null audience is for OAuth2.0 token exchange, the empty audience is for self-signed JWT with scope,
+    the template is optional and the exp claim is set to expires */
+    bool encodeJWT(GAuth_JWT_Writer &writer, const char *audience, GAuth_JWT_Template *tpl, unsigned long &expires);
+    /* sign the encoded JWT and append the signature, forPrefetch is set when it is called from the prefetch */
+    bool signJWT(GAuth_JWT_Writer &writer, bool forPrefetch = false);
+    /* write the encoded JWT header and payload */
+    void writeJWT(GAuth_JWT_Writer &writer, uint32_t now, uint32_t exp, const char *audience);
+    /* set the self-signed JWT as the access token */
+    bool handleSelfSignedJWT();
+    /* get the index of cached self-signed JWT of audience */
+    int getJWTCacheIndex(const char *audience);
+    /* add or update the cached self-signed JWT of audience */
+    void setJWTCache(const char *audience, const char *token, unsigned long expires);
+    /* wipe the cached self-signed JWTs */
+    void clearJWTCache();
+    /* get the cached or newly signed self-signed JWT of audience */
+    String getSelfSignedJWT(const char *audience);
+    /* send the request and read its response, the request is resent once when its reused session was closed by server */
+    bool sendRequest(esp_signer_gauth_token_request_t &r);
     /* request or refresh the token */
     bool requestTokens(bool refresh);
+    /* prepare the token request and its response fields */
+    bool beginTokenRequest(bool refresh);
+    /* send and read the token request within the time budget, done is set when the request was finished */
+    bool stepTokenRequest(unsigned long budget, bool &done);
+    /* handle the token response and release the token request */
+    bool endTokenRequest(bool received);
+    /* set the token request result to the retry backoff */
+    void setRequestResult(bool success, int retryAfter = -1);
+    /* release the token request */
+    void freeTokenRequest();
+    /* exchange the signed prefetch JWT for the access token, only the prefetch inputs and outcome are used */
+    bool exchangeJWT(esp_signer_gauth_prefetch_t &pf);
+    /* start the prefetch when it is time, or publish the prefetch outcome */
+    void checkPrefetch();
+    /* sign and exchange the next token, runs on the prefetch task on ESP32 */
+    void runPrefetch();
+    /* the prefetch is signing or exchanging the token */
+    bool prefetchRunning() const { return prefetchState == esp_signer_gauth_prefetch_state_running; }
+    /* the TCP client is in use by the request in progress or the prefetch task */
+    bool connectionBusy() const { return tokenRequest || (config && config->internal.processing) || prefetchRunning(); }
+#if defined(ESP32)
+    static void prefetchTask(void *param);
+#endif
     /* check the token ready status and process the token tasks */
     void checkToken();
+    /* add the callback that receives the token when it is ready or failed, all waiters share the same token request */
+    bool requestTokenAsync(TokenRequestCallback callback, void *arg);
+    /* deliver the token to the waiters when the token processing was finished */
+    void notifyWaiters();
     /* parse expiry time from string */
     void getExpiration(const char *exp);
     /* return error string from code */
@@ -136,8 +272,8 @@ private:
     bool tokenReady();
     /* error status callback */
     void sendTokenStatusCB();
-    /* prepare or initialize the external/internal TCP client */
-    bool initClient(PGM_P subDomain, esp_signer_gauth_auth_token_status status = esp_signer_token_status_uninitialized);
+    /* prepare or initialize the external/internal TCP client, sessionReused is set when the kept-alive session is reused */
+    bool initClient(PGM_P subDomain, esp_signer_gauth_auth_token_status status, bool &sessionReused);
     /* get system time */
     time_t getTime();
     /* set the system time */
@@ -146,6 +282,10 @@ private:
     void setAutoReconnectWiFi(bool reconnect);
 
     void setTokenType(esp_signer_gauth_auth_token_type type);
+    /* the flash strings of the token type, status and error code, no memory is allocated */
+    static const __FlashStringHelper *tokenTypeString(esp_signer_gauth_auth_token_type type);
+    static const __FlashStringHelper *tokenStatusString(esp_signer_gauth_auth_token_status status);
+    static const __FlashStringHelper *errorString(int httpCode);
     String getTokenType(TokenInfo info);
     String getTokenType();
     String getTokenStatus(TokenInfo info);
@@ -154,7 +294,12 @@ private:
     void reset();
     void refresh();
     String getTokenError();
+    /* the current token info and the error message, without copy */
+    const TokenInfo &getTokenInfo() { return tokenInfo; }
+    const char *getTokenErrorMessage(const TokenInfo &info) { return info.error.message.c_str(); }
     unsigned long getExpiredTimestamp();
+    /* the valid server response timeout of the config */
+    unsigned long serverResponseTimeout();
     bool reconnect(GAuth_TCP_Client *client, unsigned long dataTime = 0);
     bool reconnect();
 
@@ -0,0 +1,340 @@
+/**
+ * GAuth RSA Key v1.0.0
+ *
+ * This library supports Espressif ESP8266, ESP32 and Raspberry Pi Pico MCUs.
+ *
+ * The MIT License (MIT)
+ * Copyright (c) 2022 K. Suwatchai (Mobizt)
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person returning a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef GAUTH_RSA_KEY_H
+#define GAUTH_RSA_KEY_H
+
+#include <Arduino.h>
+#include "mbfs/MB_MCU.h"
+#include "mbfs/MB_FS.h"
+#include "ESP_Signer_Helper.h"
+#include "client/SSLClient/ESP_SSLClient.h"
+
+#if defined(USE_LIB_SSL_ENGINE)
+
+extern "C"
+{
+#include "client/SSLClient/bssl/inner.h"
+}
+
+// The exponentiation window size in bits
+#define GAUTH_RSA_KEY_WINDOW_BITS 4
+
+/* The RSA private key in the form that is ready for the i31 CRT signing.
+ * The decoded factors, their Montgomery constants (-1/m mod 2^31, R mod m and R^2 mod m),
+ * iq in Montgomery representation and the modulus are computed once in prepare().
+ * The computation in sign() is the same as br_rsa_i31_pkcs1_sign and gives the same signature.
+ */
+class GAuth_RSA_Key
+{
+public:
+    GAuth_RSA_Key(){};
+    ~GAuth_RSA_Key() { clear(); }
+
+    void begin(MB_FS *mbfs) { this->mbfs = mbfs; }
+
+    /* compute the signing data from the key, the key exponents (dp and dq) are used by reference */
+    bool prepare(const br_rsa_private_key *sk)
+    {
+        clear();
+
+        if (!mbfs || !sk)
+            return false;
+
+        const unsigned char *p = sk->p, *q = sk->q;
+        size_t plen = sk->plen, qlen = sk->qlen;
+
+        while (plen > 0 && *p == 0)
+        {
+            p++;
+            plen--;
+        }
+
+        while (qlen > 0 && *q == 0)
+        {
+            q++;
+            qlen--;
+        }
+
+        if (plen == 0 || qlen == 0)
+            return false;
+
+        // the factor length in words, rounded up to an even number
+        long z = (long)(plen > qlen ? plen : qlen) << 3;
+        fwlen = 1;
+        while (z > 0)
+        {
+            z -= 31;
+            fwlen++;
+        }
+        fwlen += (fwlen & 1);
+
+        xlen = (sk->n_bitlen + 7) >> 3;
+
+        // mp, mq, onep, oneq, r2p, r2q, iqr, the modulus in bytes and 2 words temporary for the modulus product
+        bufLen = 7 * fwlen * sizeof(uint32_t) + xlen;
+        buf = MemoryHelper::createBuffer<uint8_t *>(mbfs, bufLen, false);
+        uint32_t *t = MemoryHelper::createBuffer<uint32_t *>(mbfs, 2 * fwlen * sizeof(uint32_t), false);
+
+        if (!buf || !t)
+        {
+            if (t)
+                MemoryHelper::freeBuffer(mbfs, t);
+            clear();
+            return false;
+        }
+
+        uint32_t *w = reinterpret_cast<uint32_t *>(buf);
+        mp = w;
+        mq = w + fwlen;
+        onep = w + 2 * fwlen;
+        oneq = w + 3 * fwlen;
+        r2p = w + 4 * fwlen;
+        r2q = w + 5 * fwlen;
+        iqr = w + 6 * fwlen;
+        n = buf + 7 * fwlen * sizeof(uint32_t);
+
+        br_i31_decode(mp, p, plen);
+        br_i31_decode(mq, q, qlen);
+
+        p0i = br_i31_ninv31(mp[1]);
+        q0i = br_i31_ninv31(mq[1]);
+
+        // the even factor has no Montgomery inverse, the key is invalid (as br_rsa_i31_private)
+        if (p0i == 0 || q0i == 0)
+        {
+            MemoryHelper::freeBuffer(mbfs, t);
+            clear();
+            return false;
+        }
+
+        setMonty(onep, r2p, mp);
+        setMonty(oneq, r2q, mq);
+
+        // iq * R mod p, then (s1 - s2) * iq mod p is one Montgomery multiplication
+        br_i31_decode_reduce(t, sk->iq, sk->iqlen, mp);
+        br_i31_montymul(iqr, t, r2p, mp, p0i);
+
+        // the modulus for the input range check
+        br_i31_zero(t, mq[0]);
+        br_i31_mulacc(t, mq, mp);
+        br_i31_encode(n, xlen, t);
+
+        wipe(t, 2 * fwlen * sizeof(uint32_t));
+        MemoryHelper::freeBuffer(mbfs, t);
+
+        dp = sk->dp;
+        dplen = sk->dplen;
+        dq = sk->dq;
+        dqlen = sk->dqlen;
+        nBitlen = sk->n_bitlen;
+
+        return true;
+    }
+
+    bool ready() const { return buf != nullptr; }
+
+    /* the RSA PKCS#1 v1.5 signature (as br_rsa_pkcs1_sign), the signature length is the modulus length */
+    uint32_t sign(const unsigned char *hash_oid, const unsigned char *hash, size_t hash_len, unsigned char *x)
+    {
+        if (!ready() || !br_rsa_pkcs1_sig_pad(hash_oid, hash, hash_len, nBitlen, x))
+            return 0;
+        return privateOp(x);
+    }
+
+    /* wipe and release the signing data */
+    void clear()
+    {
+        if (buf)
+        {
+            wipe(buf, bufLen);
+            MemoryHelper::freeBuffer(mbfs, buf);
+        }
+        buf = nullptr;
+        bufLen = 0;
+        mp = mq = onep = oneq = r2p = r2q = iqr = nullptr;
+        n = nullptr;
+        dp = dq = nullptr;
+        dplen = dqlen = 0;
+        fwlen = xlen = 0;
+        nBitlen = 0;
+    }
+
+private:
+    MB_FS *mbfs = nullptr;
+    uint8_t *buf = nullptr;
+    size_t bufLen = 0;
+    size_t fwlen = 0;
+    size_t xlen = 0;
+    uint32_t nBitlen = 0;
+    uint32_t *mp = nullptr, *mq = nullptr;
+    uint32_t *onep = nullptr, *oneq = nullptr;
+    uint32_t *r2p = nullptr, *r2q = nullptr;
+    uint32_t *iqr = nullptr;
+    uint32_t p0i = 0, q0i = 0;
+    unsigned char *n = nullptr;
+    const unsigned char *dp = nullptr, *dq = nullptr;
+    size_t dplen = 0, dqlen = 0;
+
+    static void wipe(void *p, size_t len)
+    {
+        volatile uint8_t *v = reinterpret_cast<volatile uint8_t *>(p);
+        for (size_t i = 0; i < len; i++)
+            v[i] = 0;
+    }
+
+    // R mod m and R^2 mod m
+    static void setMonty(uint32_t *one, uint32_t *r2, const uint32_t *m)
+    {
+        br_i31_zero(one, m[0]);
+        one[(m[0] + 31) >> 5] = 1;
+        br_i31_muladd_small(one, 0, m);
+
+        memcpy(r2, one, ((m[0] + 63) >> 5) * sizeof(uint32_t));
+        br_i31_to_monty(r2, m);
+    }
+
+    // x = x^e mod m, as br_i31_modpow_opt with the fixed window and the precomputed R and R^2
+    void modpow(uint32_t *x, const unsigned char *e, size_t elen, const uint32_t *m, uint32_t m0i,
+                const uint32_t *one, const uint32_t *r2, uint32_t *tmp)
+    {
+        size_t mwlen = (m[0] + 63) >> 5;
+        size_t mlen = mwlen * sizeof(uint32_t);
+        uint32_t *t1 = tmp;
+        uint32_t *t2 = tmp + fwlen;
+        uint32_t *base = t2 + fwlen;
+
+        // to Montgomery representation
+        br_i31_montymul(t1, x, r2, m, m0i);
+        memcpy(x, t1, mlen);
+
+        // base[k - 1] = x^k
+        memcpy(base, x, mlen);
+        for (size_t u = 2; u < ((size_t)1 << GAUTH_RSA_KEY_WINDOW_BITS); u++)
+        {
+            br_i31_montymul(base + fwlen, base, x, m, m0i);
+            base += fwlen;
+        }
+
+        memcpy(x, one, mlen);
+
+        uint32_t acc = 0;
+        int acc_len = 0;
+        while (acc_len > 0 || elen > 0)
+        {
+            int k = GAUTH_RSA_KEY_WINDOW_BITS;
+            if (acc_len < k)
+            {
+                if (elen > 0)
+                {
+                    acc = (acc << 8) | *e++;
+                    elen--;
+                    acc_len += 8;
+                }
+                else
+                    k = acc_len;
+            }
+
+            uint32_t bits = (acc >> (acc_len - k)) & (((uint32_t)1 << k) - 1);
+            acc_len -= k;
+
+            for (int i = 0; i < k; i++)
+            {
+                br_i31_montymul(t1, x, x, m, m0i);
+                memcpy(x, t1, mlen);
+            }
+
+            // constant-time window lookup
+            br_i31_zero(t2, m[0]);
+            base = t2 + fwlen;
+            for (uint32_t u = 1; u < ((uint32_t)1 << k); u++)
+            {
+                uint32_t mask = -EQ(u, bits);
+                for (size_t v = 1; v < mwlen; v++)
+                    t2[v] |= mask & base[v];
+                base += fwlen;
+            }
+
+            br_i31_montymul(t1, x, t2, m, m0i);
+            CCOPY(NEQ(bits, 0), x, t1, mlen);
+        }
+
+        br_i31_from_monty(x, m, m0i);
+    }
+
+    // the RSA private key operation with CRT, see br_rsa_i31_private
+    uint32_t privateOp(unsigned char *x)
+    {
+        // s2 (2 words for the final product), s1, h and the exponentiation window
+        size_t wsLen = (4 + 1 + ((size_t)1 << GAUTH_RSA_KEY_WINDOW_BITS)) * fwlen * sizeof(uint32_t);
+        uint32_t *ws = MemoryHelper::createBuffer<uint32_t *>(mbfs, wsLen, false);
+        if (!ws)
+            return 0;
+
+        uint32_t *s2 = ws;
+        uint32_t *s1 = ws + 2 * fwlen;
+        uint32_t *h = ws + 3 * fwlen;
+        uint32_t *tmp = ws + 4 * fwlen;
+
+        // the input must be lower than the modulus
+        uint32_t r = 0;
+        size_t u = xlen;
+        while (u > 0)
+        {
+            u--;
+            uint32_t wn = n[u];
+            uint32_t wx = x[u];
+            r = ((wx - (wn + r)) >> 8) & 1;
+        }
+
+        // s2 = x^dq mod q
+        br_i31_decode_reduce(s2, x, xlen, mq);
+        modpow(s2, dq, dqlen, mq, q0i, oneq, r2q, tmp);
+
+        // s1 = x^dp mod p
+        br_i31_decode_reduce(s1, x, xlen, mp);
+        modpow(s1, dp, dplen, mp, p0i, onep, r2p, tmp);
+
+        // h = (s1 - s2) * (1/q) mod p
+        br_i31_reduce(h, s2, mp);
+        br_i31_add(s1, mp, br_i31_sub(s1, h, 1));
+        br_i31_montymul(h, s1, iqr, mp, p0i);
+
+        // s = s2 + q * h
+        br_i31_mulacc(s2, mq, h);
+        br_i31_encode(x, xlen, s2);
+
+        wipe(ws, wsLen);
+        MemoryHelper::freeBuffer(mbfs, ws);
+
+        return r;
+    }
+};
+
+#endif
+
+#endif
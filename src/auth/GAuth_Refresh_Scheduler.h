@@ -0,0 +1,161 @@
+/**
+ * GAuth Refresh Scheduler v1.0.0
+ *
+ * This library supports Espressif ESP8266, ESP32 and Raspberry Pi Pico MCUs.
+ *
+ * The MIT License (MIT)
+ * Copyright (c) 2022 K. Suwatchai (Mobizt)
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person returning a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef GAUTH_REFRESH_SCHEDULER_H
+#define GAUTH_REFRESH_SCHEDULER_H
+
+#include <Arduino.h>
+#include "mbfs/MB_MCU.h"
+
+/* Spreads the token requests of many devices over time.
+ * The refresh time is moved earlier by the jitter that is fixed per device seed and token expiry,
+ * the first request after the boot is delayed by the jitter that is fixed per device seed,
+ * and the failed request is retried with the decorrelated exponential backoff,
+ * delay = min(max, random(base, previous delay * 3)), or after Retry-After when it is longer.
+ * No clock is read here, the same schedule can be simulated for many seeds.
+ */
+class GAuth_Refresh_Scheduler
+{
+public:
+    GAuth_Refresh_Scheduler(){};
+
+    /* set the seed, 0 for the device (chip) id */
+    void begin(uint32_t seed)
+    {
+        this->seed = seed ? seed : deviceSeed();
+        if (this->seed == 0)
+            this->seed = 0x9e3779b9;
+        state = this->seed;
+        succeeded();
+    }
+
+    /**
+     * Get the seconds before the expiry time to refresh the token.
+     * @param preRefresh The minimum seconds before the expiry time.
+     * @param jitter The maximum seconds that are added to preRefresh.
+     * @param expires The token expiry timestamp, the same token gets the same jitter.
+     * @return The seconds before the expiry time.
+     */
+    unsigned long refreshLead(unsigned long preRefresh, unsigned long jitter, unsigned long expires) const
+    {
+        if (jitter == 0)
+            return preRefresh;
+        return preRefresh + mix(seed ^ (uint32_t)expires) % (jitter + 1);
+    }
+
+    /**
+     * Get the delay of the first token request after the boot, the devices that were powered on together are spread.
+     * @param jitter The maximum delay in ms.
+     * @return The delay in ms, the same seed gets the same delay.
+     */
+    unsigned long startDelay(unsigned long jitter) const
+    {
+        if (jitter == 0)
+            return 0;
+        return mix(seed ^ 0x5bd1e995) % (jitter + 1);
+    }
+
+    /**
+     * Set the request failure and get the delay before the next request.
+     * @param base The first (minimum) delay in ms.
+     * @param max The maximum delay in ms.
+     * @param retryAfter The Retry-After delay in ms from server or 0.
+     * @return The delay in ms.
+     */
+    unsigned long failed(unsigned long base, unsigned long max, unsigned long retryAfter)
+    {
+        if (max < base)
+            max = base;
+
+        unsigned long prev = delay < base ? base : delay;
+        unsigned long upper = prev > max / 3 ? max : prev * 3;
+
+        delay = upper > base ? base + next() % (upper - base + 1) : base;
+
+        if (retryAfter > delay)
+            delay = retryAfter;
+
+        if (failures < 0xffff)
+            failures++;
+
+        return delay;
+    }
+
+    /* reset the backoff after the successful request */
+    void succeeded()
+    {
+        delay = 0;
+        failures = 0;
+    }
+
+    /* the delay in ms before the next request, base when no request was failed */
+    unsigned long retryDelay(unsigned long base) const { return failures > 0 ? delay : base; }
+
+    /* the number of failed requests since the last successful request */
+    uint16_t failureCount() const { return failures; }
+
+private:
+    uint32_t seed = 0;
+    uint32_t state = 0;
+    unsigned long delay = 0;
+    uint16_t failures = 0;
+
+    // xorshift32
+    uint32_t next()
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    // the 32-bit finalizer of MurmurHash3
+    static uint32_t mix(uint32_t x)
+    {
+        x ^= x >> 16;
+        x *= 0x85ebca6b;
+        x ^= x >> 13;
+        x *= 0xc2b2ae35;
+        x ^= x >> 16;
+        return x;
+    }
+
+    static uint32_t deviceSeed()
+    {
+#if defined(ESP32)
+        uint64_t mac = ESP.getEfuseMac();
+        return mix((uint32_t)mac ^ (uint32_t)(mac >> 32));
+#elif defined(ESP8266)
+        return mix(ESP.getChipId());
+#else
+        return 0;
+#endif
+    }
+};
+
+#endif
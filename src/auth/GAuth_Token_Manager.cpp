@@ -0,0 +1,241 @@
+/**
+ * GAuth Token Manager v1.0.0
+ *
+ * This library supports Espressif ESP8266, ESP32 and Raspberry Pi Pico MCUs.
+ *
+ * The MIT License (MIT)
+ * Copyright (c) 2022 K. Suwatchai (Mobizt)
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person returning a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef GAUTH_TOKEN_MANAGER_CPP
+#define GAUTH_TOKEN_MANAGER_CPP
+
+#include <Arduino.h>
+#include "mbfs/MB_MCU.h"
+#include "GAuth_Token_Manager.h"
+
+void GAuth_Token_Manager::begin(GAuth_OAuth2_Client *authClient, MB_FS *mbfs, uint32_t *mb_ts, uint32_t *mb_ts_offset)
+{
+    this->authClient = authClient;
+    this->tcpClient = &authClient->tcpClient;
+    this->mbfs = mbfs;
+    this->mb_ts = mb_ts;
+    this->mb_ts_offset = mb_ts_offset;
+}
+
+int GAuth_Token_Manager::add(SignerConfig *config)
+{
+    if (!config || !tcpClient)
+        return -1;
+
+    // the duplicate is found before the config is used by the client
+    uint64_t keyId = accountId(config);
+    uint64_t scopeId = GAuth_Token_Store::scopeId(config);
+
+    int slot = -1;
+
+    for (int i = 0; i < ESP_SIGNER_MAX_TOKEN_ENTRIES; i++)
+    {
+        if (!entries[i].client)
+        {
+            if (slot < 0)
+                slot = i;
+            continue;
+        }
+
+        // the same key, client email and scope set share the same token
+        if (keyId > 0 && entries[i].keyId == keyId && entries[i].scopeId == scopeId)
+        {
+            entries[i].refs++;
+            return i;
+        }
+    }
+
+    if (slot < 0)
+        return -1;
+
+    GAuth_OAuth2_Client *client = new GAuth_OAuth2_Client();
+    client->sharedTCPClient = true;
+    client->tcpClient = *tcpClient;
+
+    if (config->signer.tokens.token_type != token_type_self_signed_jwt)
+        config->signer.tokens.token_type = token_type_oauth2_access_token;
+
+    client->begin(config, mbfs, mb_ts, mb_ts_offset);
+    client->reset();
+
+    entries[slot].config = config;
+    entries[slot].client = client;
+    entries[slot].keyId = keyId;
+    entries[slot].scopeId = scopeId;
+    entries[slot].refs = 1;
+
+    return slot;
+}
+
+bool GAuth_Token_Manager::remove(int handle)
+{
+    if (!isValid(handle))
+        return false;
+
+    if (--entries[handle].refs == 0)
+    {
+        delete entries[handle].client;
+        entries[handle] = esp_signer_token_entry_t();
+    }
+
+    return true;
+}
+
+void GAuth_Token_Manager::end()
+{
+    for (int i = 0; i < ESP_SIGNER_MAX_TOKEN_ENTRIES; i++)
+    {
+        if (entries[i].client)
+            delete entries[i].client;
+        entries[i] = esp_signer_token_entry_t();
+    }
+    lastIndex = -1;
+}
+
+void GAuth_Token_Manager::loop()
+{
+    if (!tcpClient || !*tcpClient)
+        return;
+
+    // the main client is using the TCP client, its prefetch task or its request in steps
+    if (authClient && authClient->connectionBusy())
+        return;
+
+    // the entry that started its request keeps the TCP client until the request is done
+    if (isValid(lastIndex) && entries[lastIndex].client->connectionBusy())
+    {
+        process(lastIndex);
+        return;
+    }
+
+    // round robin, the expired entry next to the last processed one is processed
+    for (int i = 1; i <= ESP_SIGNER_MAX_TOKEN_ENTRIES; i++)
+    {
+        int index = (lastIndex + i) % ESP_SIGNER_MAX_TOKEN_ENTRIES;
+        GAuth_OAuth2_Client *client = entries[index].client;
+
+        if (client && client->isExpired())
+        {
+            lastIndex = index;
+            process(index);
+            return;
+        }
+    }
+}
+
+bool GAuth_Token_Manager::connectionBusy()
+{
+    for (int i = 0; i < ESP_SIGNER_MAX_TOKEN_ENTRIES; i++)
+    {
+        if (entries[i].client && entries[i].client->connectionBusy())
+            return true;
+    }
+    return false;
+}
+
+void GAuth_Token_Manager::process(int index)
+{
+    GAuth_OAuth2_Client *client = entries[index].client;
+    // the TCP client may be re-created by ESP_Signer::begin
+    client->tcpClient = *tcpClient;
+    client->tokenReady();
+}
+
+uint64_t GAuth_Token_Manager::accountId(SignerConfig *config)
+{
+    // the same order as GAuth_OAuth2_Client::begin, the PEM text, the service account file and the private key
+    GAuth_Key_Cache key;
+    key.begin(mbfs);
+
+    if (config->signer.pk.length() > 0)
+        key.load(config->signer.pk.c_str());
+    else if (config->service_account.json.path.length() > 0)
+    {
+        // the file is not parsed here, its path and storage identify the account
+        const MB_String &path = config->service_account.json.path;
+        return GAuth_Token_Store::hash(path.c_str(), path.length()) * 31 + config->service_account.json.storage_type + 1;
+    }
+    else if (strlen_P(config->service_account.data.private_key) > 0)
+        key.load(config->service_account.data.private_key);
+
+    if (!key.ready())
+        return 0;
+
+    const MB_String &email = config->service_account.data.client_email;
+    return key.getFingerprint() ^ GAuth_Token_Store::hash(email.c_str(), email.length());
+}
+
+bool GAuth_Token_Manager::tokenReady(int handle)
+{
+    loop();
+
+    if (!isValid(handle))
+        return false;
+
+    return entries[handle].config->signer.tokens.status == esp_signer_token_status_ready;
+}
+
+String GAuth_Token_Manager::accessToken(int handle)
+{
+    if (!isValid(handle))
+        return String();
+
+    return entries[handle].config->internal.auth_token.c_str();
+}
+
+TokenView GAuth_Token_Manager::accessTokenView(int handle)
+{
+    if (!isValid(handle))
+        return TokenView();
+
+    return entries[handle].client->tokenSlot.view();
+}
+
+size_t GAuth_Token_Manager::copyAccessToken(int handle, char *buf, size_t size)
+{
+    if (!isValid(handle) || !buf || size == 0)
+        return 0;
+
+    return entries[handle].client->tokenSlot.copy(buf, size);
+}
+
+bool GAuth_Token_Manager::requestTokenAsync(int handle, TokenRequestCallback callback, void *arg)
+{
+    if (!isValid(handle) || !tcpClient || !*tcpClient)
+        return false;
+
+    GAuth_OAuth2_Client *client = entries[handle].client;
+    // the TCP client may be re-created by ESP_Signer::begin
+    client->tcpClient = *tcpClient;
+    return client->requestTokenAsync(callback, arg);
+}
+
+bool GAuth_Token_Manager::isValid(int handle)
+{
+    return handle >= 0 && handle < ESP_SIGNER_MAX_TOKEN_ENTRIES && entries[handle].client;
+}
+
+#endif
@@ -0,0 +1,94 @@
+/**
+ * GAuth Token Manager v1.0.0
+ *
+ * This library supports Espressif ESP8266, ESP32 and Raspberry Pi Pico MCUs.
+ *
+ * The MIT License (MIT)
+ * Copyright (c) 2022 K. Suwatchai (Mobizt)
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person returning a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef GAUTH_TOKEN_MANAGER_H
+#define GAUTH_TOKEN_MANAGER_H
+
+#include <Arduino.h>
+#include "mbfs/MB_MCU.h"
+#include "mbfs/MB_FS.h"
+#include "ESP_Signer_Const.h"
+#include "GAuth_OAuth2_Client.h"
+
+struct esp_signer_token_entry_t
+{
+    SignerConfig *config = nullptr;
+    GAuth_OAuth2_Client *client = nullptr;
+    /* the private key and client email (or the service account file) identity */
+    uint64_t keyId = 0;
+    /* the scope set, token type and audience fingerprint */
+    uint64_t scopeId = 0;
+    /* number of handles that share this entry */
+    uint8_t refs = 0;
+};
+
+/* Keeps the tokens of additional service accounts and scopes.
+ * All entries use the same TCP client and are refreshed one at a time from loop().
+ */
+class GAuth_Token_Manager
+{
+    friend class ESP_Signer;
+
+public:
+    GAuth_Token_Manager(){};
+    ~GAuth_Token_Manager() { end(); }
+
+private:
+    esp_signer_token_entry_t entries[ESP_SIGNER_MAX_TOKEN_ENTRIES];
+    /* the main client, the owner of the TCP client */
+    GAuth_OAuth2_Client *authClient = nullptr;
+    GAuth_TCP_Client **tcpClient = nullptr;
+    MB_FS *mbfs = nullptr;
+    uint32_t *mb_ts = nullptr;
+    uint32_t *mb_ts_offset = nullptr;
+    /* the last processed entry index for round robin scheduling */
+    int lastIndex = -1;
+
+    void begin(GAuth_OAuth2_Client *authClient, MB_FS *mbfs, uint32_t *mb_ts, uint32_t *mb_ts_offset);
+    /* add the credentials and return its handle or -1 when the table is full */
+    int add(SignerConfig *config);
+    /* release the handle, the entry is removed when no handle refers to it */
+    bool remove(int handle);
+    /* remove all entries */
+    void end();
+    /* process the expired entry, one entry per call */
+    void loop();
+    /* an entry is using the TCP client */
+    bool connectionBusy();
+    void process(int index);
+    /* the account identity of the config without changing it, 0 when the key is not valid */
+    uint64_t accountId(SignerConfig *config);
+    bool tokenReady(int handle);
+    String accessToken(int handle);
+    TokenView accessTokenView(int handle);
+    size_t copyAccessToken(int handle, char *buf, size_t size);
+    /* wait for the token of the handle, the handles of the same entry share one token request */
+    bool requestTokenAsync(int handle, TokenRequestCallback callback, void *arg);
+    bool isValid(int handle);
+};
+
+#endif
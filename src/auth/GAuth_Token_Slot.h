@@ -0,0 +1,170 @@
+/**
+ * GAuth Token Slot v1.0.0
+ *
+ * This library supports Espressif ESP8266, ESP32 and Raspberry Pi Pico MCUs.
+ *
+ * The MIT License (MIT)
+ * Copyright (c) 2022 K. Suwatchai (Mobizt)
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person returning a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef GAUTH_TOKEN_SLOT_H
+#define GAUTH_TOKEN_SLOT_H
+
+#include <Arduino.h>
+#include "mbfs/MB_MCU.h"
+#include "mbfs/MB_FS.h"
+#include "ESP_Signer_Const.h"
+#include "ESP_Signer_Helper.h"
+
+/* The double-buffered copy of the access token for the readers on other tasks or cores.
+ * The new token is written into the buffer that is not read, then the generation is increased.
+ * The reader gets the token of the current generation without lock and copy,
+ * the token is unchanged until the token is replaced twice.
+ * The buffers are never shrunk, only the longer token reallocates the buffer that is not read,
+ * the replaced buffer is released in clear() as the reader of the older token may still use it.
+ */
+class GAuth_Token_Slot
+{
+public:
+    GAuth_Token_Slot(){};
+    ~GAuth_Token_Slot() { clear(); }
+
+    void begin(MB_FS *mbfs) { this->mbfs = mbfs; }
+
+    /* publish the new token, called by the token processing (one writer) */
+    void publish(const char *token, size_t len)
+    {
+        uint8_t next = (generation + 1) & 1;
+
+        if (!buf[next] || cap[next] < len + 1)
+        {
+            size_t size = len + 1 < ESP_SIGNER_TOKEN_SLOT_MIN_SIZE ? ESP_SIGNER_TOKEN_SLOT_MIN_SIZE : len + 1;
+            char *p = mbfs ? MemoryHelper::createBuffer<char *>(mbfs, size, false) : nullptr;
+            if (!p)
+                return;
+            if (buf[next])
+                retired.push_back(esp_signer_token_slot_buffer_t(buf[next], cap[next]));
+            buf[next] = p;
+            cap[next] = size;
+        }
+
+        memcpy(buf[next], token, len);
+        buf[next][len] = '\0';
+        length[next] = len;
+
+        // the token should be written before the generation is changed
+        __sync_synchronize();
+        generation = generation + 1;
+        __sync_synchronize();
+    }
+
+    void publish(const MB_String &token) { publish(token.c_str(), token.length()); }
+
+    /* get the current token without copy */
+    TokenView view() const
+    {
+        TokenView v;
+        uint32_t g;
+        do
+        {
+            g = generation;
+            __sync_synchronize();
+            v.token = buf[g & 1] ? buf[g & 1] : "";
+            v.length = buf[g & 1] ? length[g & 1] : 0;
+            v.generation = g;
+            __sync_synchronize();
+        } while (g != generation);
+        return v;
+    }
+
+    /**
+     * Copy the current token, the token that was replaced while copying is copied again.
+     * @param out The buffer.
+     * @param size The buffer size.
+     * @return The token length, 0 when no token, or the required length (not less than size)
+     * when the buffer is too small and nothing was copied.
+     */
+    size_t copy(char *out, size_t size) const
+    {
+        size_t len = 0;
+        uint32_t g;
+        do
+        {
+            g = generation;
+            __sync_synchronize();
+            len = buf[g & 1] ? length[g & 1] : 0;
+            if (len + 1 > size)
+            {
+                if (out && size > 0)
+                    out[0] = '\0';
+                return len + 1;
+            }
+            if (len > 0)
+                memcpy(out, buf[g & 1], len);
+            out[len] = '\0';
+            __sync_synchronize();
+        } while (g != generation);
+        return len;
+    }
+
+    /* release the buffers, no reader should use the token */
+    void clear()
+    {
+        for (uint8_t i = 0; i < 2; i++)
+        {
+            if (buf[i])
+            {
+                memset(buf[i], 0, cap[i]);
+                MemoryHelper::freeBuffer(mbfs, buf[i]);
+            }
+            buf[i] = nullptr;
+            cap[i] = 0;
+            length[i] = 0;
+        }
+
+        for (size_t i = 0; i < retired.size(); i++)
+        {
+            memset(retired[i].buf, 0, retired[i].cap);
+            MemoryHelper::freeBuffer(mbfs, retired[i].buf);
+        }
+        retired.clear();
+    }
+
+private:
+    struct esp_signer_token_slot_buffer_t
+    {
+        esp_signer_token_slot_buffer_t(char *buf = nullptr, size_t cap = 0) : buf(buf), cap(cap){};
+        char *buf;
+        size_t cap;
+    };
+
+    MB_FS *mbfs = nullptr;
+    char *buf[2] = {nullptr, nullptr};
+    size_t cap[2] = {0, 0};
+    volatile size_t length[2] = {0, 0};
+    /* the generation of current token, the current token is in buf[generation & 1] */
+    volatile uint32_t generation = 0;
+    /* the buffers that were replaced by the longer token */
+    MB_VECTOR<esp_signer_token_slot_buffer_t> retired;
+};
+
+#endif
@@ -0,0 +1,249 @@
+/**
+ * GAuth Token Store v1.0.0
+ *
+ * This library supports Espressif ESP8266, ESP32 and Raspberry Pi Pico MCUs.
+ *
+ * The MIT License (MIT)
+ * Copyright (c) 2022 K. Suwatchai (Mobizt)
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person returning a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+
+#ifndef GAUTH_TOKEN_STORE_H
+#define GAUTH_TOKEN_STORE_H
+
+#include <Arduino.h>
+#include "mbfs/MB_MCU.h"
+#include "mbfs/MB_FS.h"
+#include "ESP_Signer_Const.h"
+#include "ESP_Signer_Helper.h"
+#include "json/MB_JSON_Extractor.h"
+
+/* Keeps the access token in a file to reuse it after device restart or deep sleep.
+ * The record is checked with CRC-32 and it is used only with the same private key and scopes.
+ */
+class GAuth_Token_Store
+{
+public:
+    GAuth_Token_Store(){};
+    ~GAuth_Token_Store() { clear(); }
+
+    /**
+     * Set the file to save and load the token.
+     * @param mbfs The MB_FS object.
+     * @param filename The file name, empty to disable.
+     * @param storageType The storage type mb_fs_mem_storage_type_flash or mb_fs_mem_storage_type_sd.
+     */
+    void setFile(MB_FS *mbfs, const MB_String &filename, mb_fs_mem_storage_type storageType)
+    {
+        this->mbfs = mbfs;
+        _filename = filename;
+        if (_filename.length() > 0 && _filename[0] != '/')
+            _filename.prepend('/');
+        _storage_type = storageType;
+    }
+
+    bool fileReady() const { return mbfs && _filename.length() > 0; }
+
+    // File content: "TOK1", key id (8 bytes), scope id (8 bytes), expiry timestamp (4 bytes),
+    // token length (2 bytes), token and CRC-32 (4 bytes) of the preceding data.
+    /* read the saved token, it is kept until it is taken or cleared */
+    bool load()
+    {
+        clear();
+
+        if (!fileReady())
+            return false;
+
+        int len = mbfs->open(_filename, mbfs_type _storage_type, mb_fs_open_mode_read);
+        if (len < (int)(headerSize + 4))
+        {
+            if (len > -1)
+                mbfs->close(mbfs_type _storage_type);
+            return false;
+        }
+
+        uint8_t *buf = MemoryHelper::createBuffer<uint8_t *>(mbfs, len, false);
+        bool ret = buf && mbfs->read(mbfs_type _storage_type, buf, len) == len;
+        mbfs->close(mbfs_type _storage_type);
+
+        if (ret)
+        {
+            size_t tokenLen = buf[headerSize - 2] << 8 | buf[headerSize - 1];
+            ret = strncmp_P((const char *)buf, esp_signer_pgm_str_53, 4) == 0 && (size_t)len == headerSize + tokenLen + 4 &&
+                  Utils::crc32(0, buf, headerSize + tokenLen) == get32(buf + headerSize + tokenLen);
+
+            if (ret)
+            {
+                _key_id = get64(buf + 4);
+                _scope_id = get64(buf + 12);
+                _expires = get32(buf + 20);
+                // the token is followed by the CRC, not the null terminator
+                MB_JSON_Extractor::appendString(_token, (const char *)buf + headerSize, tokenLen);
+            }
+        }
+
+        if (buf)
+        {
+            memset(buf, 0, len);
+            MemoryHelper::freeBuffer(mbfs, buf);
+        }
+
+        return ret;
+    }
+
+    /**
+     * Save the token.
+     * @param keyId The private key fingerprint.
+     * @param scopeId The scope id from scopeId().
+     * @param token The access token.
+     * @param expires The expiry timestamp.
+     */
+    bool save(uint64_t keyId, uint64_t scopeId, const MB_String &token, uint32_t expires)
+    {
+        if (!fileReady() || token.length() == 0 || token.length() > 0xffff)
+            return false;
+
+        size_t len = headerSize + token.length() + 4;
+        uint8_t *buf = MemoryHelper::createBuffer<uint8_t *>(mbfs, len, false);
+        if (!buf)
+            return false;
+
+        memcpy_P(buf, esp_signer_pgm_str_53, 4);
+        put64(buf + 4, keyId);
+        put64(buf + 12, scopeId);
+        put32(buf + 20, expires);
+        buf[headerSize - 2] = token.length() >> 8;
+        buf[headerSize - 1] = token.length() & 0xff;
+        memcpy(buf + headerSize, token.c_str(), token.length());
+        put32(buf + headerSize + token.length(), Utils::crc32(0, buf, headerSize + token.length()));
+
+        bool ret = mbfs->open(_filename, mbfs_type _storage_type, mb_fs_open_mode_write) > -1;
+        if (ret)
+        {
+            ret = mbfs->write(mbfs_type _storage_type, buf, len) == (int)len;
+            mbfs->close(mbfs_type _storage_type);
+        }
+
+        memset(buf, 0, len);
+        MemoryHelper::freeBuffer(mbfs, buf);
+
+        return ret;
+    }
+
+    /* the loaded token is for this key and scopes */
+    bool match(uint64_t keyId, uint64_t scopeId) const
+    {
+        return _token.length() > 0 && keyId > 0 && _key_id == keyId && _scope_id == scopeId;
+    }
+
+    uint32_t expires() const { return _expires; }
+
+    /* move the loaded token out */
+    void take(MB_String &token)
+    {
+        token.swap(_token);
+        clear();
+    }
+
+    /* wipe the loaded token */
+    void clear()
+    {
+        if (_token.length() > 0)
+        {
+            volatile char *p = (volatile char *)_token.c_str();
+            for (size_t i = 0; i < _token.length(); i++)
+                p[i] = 0;
+        }
+        _token.clear();
+        _key_id = 0;
+        _scope_id = 0;
+        _expires = 0;
+    }
+
+    /* the fingerprint of the scope set (order insensitive), audience and token type */
+    static uint64_t scopeId(esp_signer_gauth_cfg_t *config)
+    {
+        uint64_t id = 0;
+
+        // the sum of each scope hash, does not depend on the scope order
+        const char *p = config->signer.tokens.scope.c_str();
+        while (*p)
+        {
+            while (*p && (*p == ',' || isspace(*p)))
+                p++;
+
+            size_t n = 0;
+            while (p[n] && p[n] != ',' && !isspace(p[n]))
+                n++;
+
+            if (n > 0)
+                id += hash(p, n);
+
+            p += n;
+        }
+
+        id = id * 31 + hash(config->signer.tokens.audience.c_str(), config->signer.tokens.audience.length());
+        // the undefined type is requested as the OAuth2.0 access token
+        id = id * 31 + (config->signer.tokens.token_type == token_type_self_signed_jwt ? token_type_self_signed_jwt : token_type_oauth2_access_token);
+
+        return id;
+    }
+
+    static uint64_t hash(const char *s, size_t len)
+    {
+        // FNV-1a
+        uint64_t h = 0xcbf29ce484222325ULL;
+        for (size_t i = 0; i < len; i++)
+        {
+            h ^= (uint8_t)s[i];
+            h *= 0x100000001b3ULL;
+        }
+        return h;
+    }
+
+private:
+    static const size_t headerSize = 26;
+    MB_FS *mbfs = nullptr;
+    MB_String _filename;
+    mb_fs_mem_storage_type _storage_type = mb_fs_mem_storage_type_flash;
+    MB_String _token;
+    uint64_t _key_id = 0;
+    uint64_t _scope_id = 0;
+    uint32_t _expires = 0;
+
+    static uint32_t get32(const uint8_t *p) { return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3]; }
+
+    static uint64_t get64(const uint8_t *p) { return (uint64_t)get32(p) << 32 | get32(p + 4); }
+
+    static void put32(uint8_t *p, uint32_t v)
+    {
+        for (int i = 3; i >= 0; i--, v >>= 8)
+            p[i] = v & 0xff;
+    }
+
+    static void put64(uint8_t *p, uint64_t v)
+    {
+        put32(p, v >> 32);
+        put32(p + 4, v & 0xffffffff);
+    }
+};
+
+#endif
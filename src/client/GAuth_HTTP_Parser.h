@@ -0,0 +1,333 @@
+/**
+ * GAuth HTTP Parser v1.0.0
+ *
+ * This library supports Espressif ESP8266, ESP32 and Raspberry Pi Pico MCUs.
+ *
+ * The MIT License (MIT)
+ * Copyright (c) 2022 K. Suwatchai (Mobizt)
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person returning a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef GAUTH_HTTP_PARSER_H
+#define GAUTH_HTTP_PARSER_H
+
+#include <Arduino.h>
+#include "../ESP_Signer_Const.h"
+#include "../client/GAuth_TCP_Client.h"
+#include "../json/MB_JSON_Extractor.h"
+
+#define GAUTH_HTTP_PARSER_LINE_SIZE 128
+
+/* The receiver of the response payload */
+class GAuth_HTTP_Body_Sink
+{
+public:
+  virtual ~GAuth_HTTP_Body_Sink(){};
+  virtual void write(const char *data, size_t len) = 0;
+};
+
+/* Passes the response payload to the JSON field extractor */
+class GAuth_HTTP_JSON_Sink : public GAuth_HTTP_Body_Sink
+{
+public:
+  GAuth_HTTP_JSON_Sink(MB_JSON_Extractor &extractor) : extractor(extractor){};
+  void write(const char *data, size_t len) override { extractor.parse(data, len); }
+
+private:
+  MB_JSON_Extractor &extractor;
+};
+
+typedef enum
+{
+  gauth_http_state_status,
+  gauth_http_state_header,
+  gauth_http_state_body,
+  gauth_http_state_chunk_size,
+  gauth_http_state_chunk_data,
+  gauth_http_state_chunk_data_end,
+  gauth_http_state_trailer,
+  gauth_http_state_complete,
+  gauth_http_state_error
+} gauth_http_parser_state;
+
+/* The incremental HTTP/1.1 response parser.
+ * The status line, headers, content length and chunked payload are parsed in one pass while the data
+ * is consumed from the client receive buffer, the payload is passed to the sink as it arrives.
+ * Only the header lines up to GAUTH_HTTP_PARSER_LINE_SIZE are kept at a time.
+ */
+class GAuth_HTTP_Parser
+{
+public:
+  GAuth_HTTP_Parser(GAuth_HTTP_Body_Sink *sink = nullptr) : sink(sink){};
+
+  /**
+   * Parse the data.
+   * @param data The received data.
+   * @param len The length of data.
+   * @return The number of bytes that were consumed.
+   */
+  size_t parse(const char *data, size_t len)
+  {
+    size_t i = 0;
+    while (i < len && !complete() && !error())
+    {
+      switch (state)
+      {
+      case gauth_http_state_body:
+      case gauth_http_state_chunk_data:
+      {
+        size_t n = len - i;
+        if (remaining > -1 && (size_t)remaining < n)
+          n = remaining;
+
+        if (sink)
+          sink->write(data + i, n);
+
+        payloadRead += n;
+        i += n;
+
+        if (remaining > -1)
+        {
+          remaining -= n;
+          if (remaining == 0)
+            state = state == gauth_http_state_body ? gauth_http_state_complete : gauth_http_state_chunk_data_end;
+        }
+        break;
+      }
+
+      default:
+      {
+        // line based states
+        const char *nl = (const char *)memchr(data + i, '\n', len - i);
+        size_t n = nl ? nl - (data + i) + 1 : len - i;
+        appendLine(data + i, n);
+        i += n;
+        if (nl)
+        {
+          parseLine();
+          lineLen = 0;
+        }
+        break;
+      }
+      }
+    }
+    return i;
+  }
+
+  /**
+   * Parse the data from the client receive buffer.
+   * @param client The GAuth_TCP_Client.
+   * @return The number of bytes that were consumed.
+   */
+  int read(GAuth_TCP_Client *client)
+  {
+    if (!client)
+      return 0;
+
+    size_t avail = client->peekAvailable();
+    const char *p = client->peekBuffer();
+
+    if (avail > 0 && p)
+    {
+      size_t n = parse(p, avail);
+      client->peekConsume(n);
+      return n;
+    }
+
+    // the data is not in the decrypted receive buffer
+    char buf[GAUTH_HTTP_PARSER_LINE_SIZE];
+    int total = 0;
+    while (client->available() > 0 && !complete() && !error())
+    {
+      int len = client->available();
+      if (len > (int)sizeof(buf))
+        len = sizeof(buf);
+      len = client->readBytes(buf, len);
+      if (len <= 0)
+        break;
+      parse(buf, len);
+      total += len;
+    }
+    return total;
+  }
+
+  /**
+   * Set the end of data e.g. the connection was closed.
+   */
+  void end()
+  {
+    // the payload without content length ends with the connection
+    if (state == gauth_http_state_body && remaining < 0)
+      state = gauth_http_state_complete;
+    else if (!complete())
+      state = gauth_http_state_error;
+  }
+
+  bool complete() const { return state == gauth_http_state_complete; }
+
+  bool error() const { return state == gauth_http_state_error; }
+
+  /* the status line was received */
+  bool started() const { return httpCode > 0; }
+
+  int httpCode = 0;
+  /* the content length header value or -1 */
+  int contentLength = -1;
+  int payloadRead = 0;
+  bool chunked = false;
+  /* the server will close the connection */
+  bool connectionClose = false;
+  /* the Retry-After seconds, the HTTP date is not supported, -1 when not set */
+  int retryAfter = -1;
+
+private:
+  GAuth_HTTP_Body_Sink *sink = nullptr;
+  gauth_http_parser_state state = gauth_http_state_status;
+  /* the remaining bytes of the content or current chunk, -1 when unknown */
+  int remaining = -1;
+  char line[GAUTH_HTTP_PARSER_LINE_SIZE];
+  size_t lineLen = 0;
+
+  void appendLine(const char *data, size_t n)
+  {
+    // the long line is truncated, only the short header values are used
+    if (lineLen + n > sizeof(line) - 1)
+      n = sizeof(line) - 1 - lineLen;
+    memcpy(line + lineLen, data, n);
+    lineLen += n;
+    line[lineLen] = '\0';
+  }
+
+  bool emptyLine() { return lineLen == 0 || line[0] == '\r' || line[0] == '\n'; }
+
+  // Case insensitive match of the header name e.g. "Connection: ", returns the value
+  const char *headerValue(PGM_P name)
+  {
+    size_t len = strlen_P(name) - 2; // without ": "
+    for (size_t i = 0; i < len; i++)
+    {
+      if (i >= lineLen || tolower(line[i]) != tolower(pgm_read_byte(name + i)))
+        return nullptr;
+    }
+
+    if (line[len] != ':')
+      return nullptr;
+
+    const char *p = line + len + 1;
+    while (*p == ' ' || *p == '\t')
+      p++;
+    return p;
+  }
+
+  bool hasToken(const char *value, PGM_P token)
+  {
+    size_t len = strlen_P(token);
+    for (const char *p = value; *p; p++)
+    {
+      size_t i = 0;
+      while (i < len && p[i] && tolower(p[i]) == tolower(pgm_read_byte(token + i)))
+        i++;
+      if (i == len)
+        return true;
+    }
+    return false;
+  }
+
+  void parseLine()
+  {
+    switch (state)
+    {
+    case gauth_http_state_status:
+      // HTTP/1.1 200 OK
+      if (strncmp_P(line, esp_signer_pgm_str_27 /* "HTTP/1.1 " */, 5) == 0)
+      {
+        const char *p = strchr(line, ' ');
+        httpCode = p ? atoi(p + 1) : 0;
+        state = httpCode > 0 ? gauth_http_state_header : gauth_http_state_error;
+      }
+      else if (!emptyLine())
+        state = gauth_http_state_error;
+      break;
+
+    case gauth_http_state_header:
+      if (emptyLine())
+        headerEnded();
+      else
+      {
+        const char *v = nullptr;
+        if ((v = headerValue(esp_signer_pgm_str_22 /* "Content-Length: " */)) != nullptr)
+          contentLength = atoi(v);
+        else if ((v = headerValue(esp_signer_pgm_str_24 /* "Transfer-Encoding: " */)) != nullptr)
+          chunked = hasToken(v, esp_signer_pgm_str_25 /* "chunked" */);
+        else if ((v = headerValue(esp_signer_pgm_str_20 /* "Connection: " */)) != nullptr)
+          connectionClose = hasToken(v, esp_signer_pgm_str_51 /* "close" */);
+        else if ((v = headerValue(esp_signer_pgm_str_54 /* "Retry-After: " */)) != nullptr && isdigit(*v))
+          retryAfter = atoi(v);
+      }
+      break;
+
+    case gauth_http_state_chunk_size:
+      // chunk size in hex, may follow by the chunk extension
+      remaining = strtol(line, nullptr, 16);
+      state = remaining > 0 ? gauth_http_state_chunk_data : gauth_http_state_trailer;
+      break;
+
+    case gauth_http_state_chunk_data_end:
+      // the CRLF after chunk data
+      state = gauth_http_state_chunk_size;
+      break;
+
+    case gauth_http_state_trailer:
+      if (emptyLine())
+        state = gauth_http_state_complete;
+      break;
+
+    default:
+      break;
+    }
+  }
+
+  void headerEnded()
+  {
+    // the informational response e.g. 100 Continue, the final response follows
+    if (httpCode >= 100 && httpCode < 200)
+    {
+      state = gauth_http_state_status;
+      httpCode = 0;
+      contentLength = -1;
+      chunked = false;
+      return;
+    }
+
+    if (httpCode == 204 || httpCode == 304)
+      state = gauth_http_state_complete;
+    else if (chunked)
+      state = gauth_http_state_chunk_size;
+    else if (contentLength == 0)
+      state = gauth_http_state_complete;
+    else
+    {
+      remaining = contentLength;
+      state = gauth_http_state_body;
+    }
+  }
+};
+
+#endif
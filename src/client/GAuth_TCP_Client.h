@@ -35,6 +35,7 @@
 #include "../mbfs/MB_FS.h"
 #include "../ESP_Signer_Helper.h"
 #include "../client/SSLClient/ESP_SSLClient.h"
+#include "../client/GAuth_TLS_Session_Cache.h"
 #include "../ESP_Signer_Network.h"
 
 #if defined(ESP32)
@@ -534,8 +535,26 @@ public:
 
     _tcp_client->setClient(_basic_client);
     _tcp_client->setDebugLevel(2);
+
+#if defined(USE_EMBED_SSL_ENGINE) || defined(USE_LIB_SSL_ENGINE)
+    // resume the previous TLS session of this host when available
+    if (_config)
+      _session_cache.setFile(_mbfs, _config->tls_session.file, mbfs_type _config->tls_session.file_storage);
+    _tcp_client->setSession(_session_cache.get(_host.c_str(), _port));
+#endif
+
     if (!_tcp_client->connect(_host.c_str(), _port))
+    {
+#if defined(USE_EMBED_SSL_ENGINE) || defined(USE_LIB_SSL_ENGINE)
+      _session_cache.remove(_host.c_str(), _port);
+#endif
       return setError(ESP_SIGNER_ERROR_TCP_ERROR_CONNECTION_REFUSED);
+    }
+
+#if defined(USE_EMBED_SSL_ENGINE) || defined(USE_LIB_SSL_ENGINE)
+    // the session parameters were updated by the handshake
+    _session_cache.update();
+#endif
 
 #if defined(ESP_SIGNER_WIFI_IS_AVAILABLE) && (defined(ESP32) || defined(ESP8266) || defined(MB_ARDUINO_PICO))
     if (_client_type == esp_signer_client_type_internal_basic_client)
@@ -582,6 +601,21 @@ public:
     return ret;
   }
 
+  /**
+   * Check whether the open session to the host can be reused for the next request.
+   * @param host The host name.
+   * @param port The port.
+   * @return true when the session is still open and no unread data left.
+   */
+  bool sessionAlive(const char *host, uint16_t port)
+  {
+    if (!connected() || _port != port || strcmp(_host.c_str(), host) != 0)
+      return false;
+
+    // any data on the idle session e.g. the close notify alert, means the session is going to close
+    return _tcp_client->available() == 0 && connected();
+  }
+
   /**
    * Stop TCP connection.
    */
@@ -748,6 +782,44 @@ public:
     return readBytes((uint8_t *)buf, len);
   }
 
+  /**
+   * Get the number of decrypted bytes that can be accessed by peekBuffer.
+   * @return The number of bytes.
+   */
+  size_t peekAvailable()
+  {
+#if defined(USE_EMBED_SSL_ENGINE) || defined(USE_LIB_SSL_ENGINE)
+    if (_tcp_client)
+      return _tcp_client->peekAvailable();
+#endif
+    return 0;
+  }
+
+  /**
+   * Get the decrypted receive buffer, no read is allowed before peekConsume.
+   * @return The buffer of peekAvailable() bytes.
+   */
+  const char *peekBuffer()
+  {
+#if defined(USE_EMBED_SSL_ENGINE) || defined(USE_LIB_SSL_ENGINE)
+    if (_tcp_client)
+      return _tcp_client->peekBuffer();
+#endif
+    return nullptr;
+  }
+
+  /**
+   * Remove the bytes from the decrypted receive buffer.
+   * @param consume The number of bytes.
+   */
+  void peekConsume(size_t consume)
+  {
+#if defined(USE_EMBED_SSL_ENGINE) || defined(USE_LIB_SSL_ENGINE)
+    if (_tcp_client)
+      _tcp_client->peekConsume(consume);
+#endif
+  }
+
   /**
    * Wait for all receive buffer data read.
    */
@@ -969,6 +1041,9 @@ private:
 
   ESP_SSLClient *_tcp_client = nullptr;
   X509List *_x509 = nullptr;
+#if defined(USE_EMBED_SSL_ENGINE) || defined(USE_LIB_SSL_ENGINE)
+  GAuth_TLS_Session_Cache _session_cache;
+#endif
 
   MB_String _host;
   uint16_t _port = 443;
@@ -0,0 +1,300 @@
+/**
+ * GAuth TLS Session Cache v1.0.0
+ *
+ * This library supports Espressif ESP8266, ESP32 and Raspberry Pi Pico MCUs.
+ *
+ * The MIT License (MIT)
+ * Copyright (c) 2022 K. Suwatchai (Mobizt)
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person returning a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef GAUTH_TLS_SESSION_CACHE_H
+#define GAUTH_TLS_SESSION_CACHE_H
+
+#include <Arduino.h>
+#include "../ESP_Signer_Const.h"
+#include "../mbfs/MB_FS.h"
+#include "../ESP_Signer_Helper.h"
+#include "../client/SSLClient/ESP_SSLClient.h"
+
+#if defined(USE_EMBED_SSL_ENGINE) || defined(USE_LIB_SSL_ENGINE)
+
+struct esp_signer_tls_session_item_t
+{
+  MB_String host;
+  uint16_t port = 0;
+  /* used order, the least recently used item will be replaced */
+  uint32_t used = 0;
+  BearSSL_Session session;
+};
+
+/* The TLS session parameters by host and port for session resumption (abbreviated handshake).
+ * The sessions can be saved to file to keep them over device restart or deep sleep.
+ */
+class GAuth_TLS_Session_Cache
+{
+public:
+  GAuth_TLS_Session_Cache() { memset(&_last, 0, sizeof(br_ssl_session_parameters)); };
+  ~GAuth_TLS_Session_Cache() { clear(); }
+
+  /**
+   * Set the file to save and load the sessions.
+   * The file contains the session secrets (master secret) of the resumable sessions,
+   * it should be kept in the storage that is not accessible by others.
+   * @param mbfs The MB_FS object.
+   * @param filename The file name, empty for memory only cache.
+   * @param storageType The storage type mb_fs_mem_storage_type_flash or mb_fs_mem_storage_type_sd.
+   */
+  void setFile(MB_FS *mbfs, const MB_String &filename, mb_fs_mem_storage_type storageType)
+  {
+    MB_String name = filename;
+    if (name.length() > 0 && name[0] != '/')
+      name.prepend('/');
+
+    if (this->mbfs == mbfs && _filename == name && _storage_type == storageType)
+      return;
+
+    this->mbfs = mbfs;
+    _filename = name;
+    _storage_type = storageType;
+    _loaded = false;
+  }
+
+  /**
+   * Get the session of host and port, the new one will be added when not found.
+   * @param host The host name.
+   * @param port The port.
+   * @return The session to use with setSession.
+   */
+  BearSSL_Session *get(const char *host, uint16_t port)
+  {
+    load();
+
+    esp_signer_tls_session_item_t *item = find(host, port);
+
+    if (!item)
+    {
+      item = &_items[0];
+      for (size_t i = 1; i < ESP_SIGNER_MAX_TLS_SESSION_CACHE; i++)
+      {
+        if (_items[i].used < item->used)
+          item = &_items[i];
+      }
+
+      item->host = host;
+      item->port = port;
+      memset(item->session.getSession(), 0, sizeof(br_ssl_session_parameters));
+    }
+
+    item->used = ++_used;
+    // keep a copy to check for the session changes after the handshake
+    memcpy(&_last, item->session.getSession(), sizeof(br_ssl_session_parameters));
+    _current = item;
+    return &item->session;
+  }
+
+  /**
+   * Save the sessions when the session from last get() was changed by the handshake.
+   */
+  void update()
+  {
+    if (_current && memcmp(&_last, _current->session.getSession(), sizeof(br_ssl_session_parameters)) != 0)
+    {
+      memcpy(&_last, _current->session.getSession(), sizeof(br_ssl_session_parameters));
+      save();
+    }
+  }
+
+  /**
+   * Remove the session of host and port e.g. when the connection was failed.
+   * @param host The host name.
+   * @param port The port.
+   */
+  void remove(const char *host, uint16_t port)
+  {
+    esp_signer_tls_session_item_t *item = find(host, port);
+    if (item)
+    {
+      if (item == _current)
+        _current = nullptr;
+      wipe(*item);
+      save();
+    }
+  }
+
+  /**
+   * Wipe all sessions from memory.
+   */
+  void clear()
+  {
+    for (size_t i = 0; i < ESP_SIGNER_MAX_TLS_SESSION_CACHE; i++)
+      wipe(_items[i]);
+    memset(&_last, 0, sizeof(br_ssl_session_parameters));
+    _current = nullptr;
+    _used = 0;
+  }
+
+private:
+  MB_FS *mbfs = nullptr;
+  MB_String _filename;
+  mb_fs_mem_storage_type _storage_type = mb_fs_mem_storage_type_flash;
+  bool _loaded = false;
+  uint32_t _used = 0;
+  br_ssl_session_parameters _last;
+  esp_signer_tls_session_item_t *_current = nullptr;
+  esp_signer_tls_session_item_t _items[ESP_SIGNER_MAX_TLS_SESSION_CACHE];
+
+  esp_signer_tls_session_item_t *find(const char *host, uint16_t port)
+  {
+    for (size_t i = 0; i < ESP_SIGNER_MAX_TLS_SESSION_CACHE; i++)
+    {
+      if (_items[i].used > 0 && _items[i].port == port && strcmp(_items[i].host.c_str(), host) == 0)
+        return &_items[i];
+    }
+    return nullptr;
+  }
+
+  void wipe(esp_signer_tls_session_item_t &item)
+  {
+    volatile uint8_t *p = (volatile uint8_t *)item.session.getSession();
+    for (size_t i = 0; i < sizeof(br_ssl_session_parameters); i++)
+      p[i] = 0;
+    item.host.clear();
+    item.port = 0;
+    item.used = 0;
+  }
+
+  bool fileReady() { return mbfs && _filename.length() > 0; }
+
+  // File content: "TLS" + version, item size, item count, then the items of
+  // host length (1 byte), host, port (2 bytes) and the session parameters,
+  // and the CRC-32 of all previous bytes (4 bytes, big endian).
+  void load()
+  {
+    if (_loaded || !fileReady())
+      return;
+
+    _loaded = true;
+
+    int len = mbfs->open(_filename, mbfs_type _storage_type, mb_fs_open_mode_read);
+    if (len < 6)
+    {
+      if (len > -1)
+        mbfs->close(mbfs_type _storage_type);
+      return;
+    }
+
+    uint32_t crc = 0;
+    uint8_t head[6];
+    if (read(head, 6, crc) && strncmp_P((const char *)head, esp_signer_pgm_str_52, 4) == 0 &&
+        head[4] == sizeof(br_ssl_session_parameters) && head[5] <= ESP_SIGNER_MAX_TLS_SESSION_CACHE)
+    {
+      bool ret = true;
+
+      for (size_t i = 0; i < head[5]; i++)
+      {
+        uint8_t hostLen = 0;
+        uint8_t port[2];
+        char host[256];
+
+        if (!read(&hostLen, 1, crc) || !read((uint8_t *)host, hostLen, crc) || !read(port, 2, crc) ||
+            !read((uint8_t *)_items[i].session.getSession(), sizeof(br_ssl_session_parameters), crc))
+        {
+          ret = false;
+          break;
+        }
+
+        host[hostLen] = '\0';
+        _items[i].host = host;
+        _items[i].port = port[0] << 8 | port[1];
+        _items[i].used = ++_used;
+      }
+
+      // the truncated or corrupted file is not used
+      uint8_t trailer[4];
+      uint32_t expected = crc;
+      if (!ret || !read(trailer, 4, crc) ||
+          ((uint32_t)trailer[0] << 24 | (uint32_t)trailer[1] << 16 | (uint32_t)trailer[2] << 8 | trailer[3]) != expected)
+        clear();
+    }
+
+    mbfs->close(mbfs_type _storage_type);
+  }
+
+  // read from the opened file and update the crc
+  bool read(uint8_t *data, size_t len, uint32_t &crc)
+  {
+    if (len > 0 && mbfs->read(mbfs_type _storage_type, data, len) != (int)len)
+      return false;
+    crc = Utils::crc32(crc, data, len);
+    return true;
+  }
+
+  void write(const uint8_t *data, size_t len, uint32_t &crc)
+  {
+    mbfs->write(mbfs_type _storage_type, (uint8_t *)data, len);
+    crc = Utils::crc32(crc, data, len);
+  }
+
+  void save()
+  {
+    if (!fileReady())
+      return;
+
+    if (mbfs->open(_filename, mbfs_type _storage_type, mb_fs_open_mode_write) < 0)
+      return;
+
+    uint8_t head[6];
+    memcpy_P(head, esp_signer_pgm_str_52, 4);
+    head[4] = sizeof(br_ssl_session_parameters);
+    head[5] = 0;
+
+    for (size_t i = 0; i < ESP_SIGNER_MAX_TLS_SESSION_CACHE; i++)
+    {
+      if (_items[i].used > 0 && _items[i].host.length() < 256)
+        head[5]++;
+    }
+
+    uint32_t crc = 0;
+    write(head, 6, crc);
+
+    for (size_t i = 0; i < ESP_SIGNER_MAX_TLS_SESSION_CACHE; i++)
+    {
+      if (_items[i].used == 0 || _items[i].host.length() >= 256)
+        continue;
+
+      uint8_t hostLen = _items[i].host.length();
+      uint8_t port[2] = {(uint8_t)(_items[i].port >> 8), (uint8_t)(_items[i].port & 0xff)};
+      write(&hostLen, 1, crc);
+      write((const uint8_t *)_items[i].host.c_str(), hostLen, crc);
+      write(port, 2, crc);
+      write((const uint8_t *)_items[i].session.getSession(), sizeof(br_ssl_session_parameters), crc);
+    }
+
+    uint8_t trailer[4] = {(uint8_t)(crc >> 24), (uint8_t)(crc >> 16), (uint8_t)(crc >> 8), (uint8_t)crc};
+    mbfs->write(mbfs_type _storage_type, trailer, 4);
+
+    mbfs->close(mbfs_type _storage_type);
+  }
+};
+
+#endif
+
+#endif
@@ -0,0 +1,627 @@
+/*
+ * The streaming JSON field extractor, MB_JSON_Extractor v1.0.0
+ *
+ * Created October 18, 2026
+ *
+ * The MIT License (MIT)
+ * Copyright (c) 2023 K. Suwatchai (Mobizt)
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef MB_JSON_EXTRACTOR_H
+#define MB_JSON_EXTRACTOR_H
+
+#include <Arduino.h>
+#include "MB_String.h"
+
+#ifndef MB_JSON_EXTRACTOR_MAX_FIELDS
+#define MB_JSON_EXTRACTOR_MAX_FIELDS 8
+#endif
+
+// the maximum number of key path segments e.g. "error/code" is 2
+#ifndef MB_JSON_EXTRACTOR_MAX_PATH_DEPTH
+#define MB_JSON_EXTRACTOR_MAX_PATH_DEPTH 4
+#endif
+
+// the maximum nesting level of JSON objects and arrays
+#define MB_JSON_EXTRACTOR_MAX_DEPTH 32
+
+typedef enum
+{
+    mb_json_extractor_type_undefined,
+    mb_json_extractor_type_string,
+    mb_json_extractor_type_literal, // number, true, false and null
+    mb_json_extractor_type_object,
+    mb_json_extractor_type_array
+} mb_json_extractor_value_type;
+
+/* The callback to receive the string value data as it is parsed (unescaped) */
+typedef void (*MB_JSON_ExtractorValueCallback)(void *arg, const char *data, size_t len);
+
+struct mb_json_extractor_field_t
+{
+    PGM_P path = nullptr;
+    uint8_t segOffset[MB_JSON_EXTRACTOR_MAX_PATH_DEPTH];
+    uint8_t segLen[MB_JSON_EXTRACTOR_MAX_PATH_DEPTH];
+    uint8_t segCount = 0;
+    // the caller-owned output
+    char *buf = nullptr;
+    size_t size = 0;
+    MB_String *str = nullptr;
+    MB_JSON_ExtractorValueCallback cb = nullptr;
+    void *arg = nullptr;
+    // the value length, can be larger than the buffer
+    size_t len = 0;
+    bool found = false;
+    mb_json_extractor_value_type type = mb_json_extractor_type_undefined;
+};
+
+/* The single pass (SAX style) JSON parser that extracts only the values of the added key paths.
+ * The data can be parsed in chunks of any size, no JSON tree or value copies are created.
+ * The key paths e.g. "error/message" are split into segments once when they are added.
+ * The object members inside arrays are not matched.
+ */
+class MB_JSON_Extractor
+{
+public:
+    MB_JSON_Extractor() { clear(); };
+    ~MB_JSON_Extractor(){};
+
+    /**
+     * Add the key path to check for its existence and value type only.
+     * @param path The PROGMEM key path, use "/" to separate the keys e.g. "error/code".
+     * @return The field index or -1 for error.
+     */
+    int add(PGM_P path)
+    {
+        if (!path || count >= MB_JSON_EXTRACTOR_MAX_FIELDS)
+            return -1;
+
+        mb_json_extractor_field_t &f = fields[count];
+        f = mb_json_extractor_field_t();
+        f.path = path;
+
+        // split the path into segments
+        size_t len = strlen_P(path);
+        size_t start = 0;
+        for (size_t i = 0; i <= len; i++)
+        {
+            if (i == len || pgm_read_byte(path + i) == '/')
+            {
+                if (f.segCount >= MB_JSON_EXTRACTOR_MAX_PATH_DEPTH || start > 255 || i - start > 255 || i == start)
+                    return -1;
+                f.segOffset[f.segCount] = start;
+                f.segLen[f.segCount] = i - start;
+                f.segCount++;
+                start = i + 1;
+            }
+        }
+
+        count++;
+        levelMask[0] = fieldMask();
+        return count - 1;
+    }
+
+    /**
+     * Add the key path to extract its value into the null-terminated buffer.
+     * @param path The PROGMEM key path, use "/" to separate the keys e.g. "error/code".
+     * @param buf The output buffer, the value longer than the buffer will be truncated.
+     * @param size The size of buffer.
+     * @return The field index or -1 for error.
+     */
+    int add(PGM_P path, char *buf, size_t size)
+    {
+        int index = add(path);
+        if (index > -1)
+        {
+            fields[index].buf = buf;
+            fields[index].size = size;
+            if (buf && size > 0)
+                buf[0] = '\0';
+        }
+        return index;
+    }
+
+    /**
+     * Add the key path to extract its value into string.
+     * @param path The PROGMEM key path, use "/" to separate the keys.
+     * @param str The output string, the value is appended.
+     * @return The field index or -1 for error.
+     */
+    int add(PGM_P path, MB_String *str)
+    {
+        int index = add(path);
+        if (index > -1)
+            fields[index].str = str;
+        return index;
+    }
+
+    /**
+     * Add the key path to receive its string value through callback.
+     * @param path The PROGMEM key path, use "/" to separate the keys.
+     * @param cb The callback function.
+     * @param arg The argument to pass to the callback function.
+     * @return The field index or -1 for error.
+     */
+    int add(PGM_P path, MB_JSON_ExtractorValueCallback cb, void *arg)
+    {
+        int index = add(path);
+        if (index > -1)
+        {
+            fields[index].cb = cb;
+            fields[index].arg = arg;
+        }
+        return index;
+    }
+
+    /**
+     * Remove all fields and reset the parser.
+     */
+    void clear()
+    {
+        count = 0;
+        reset();
+    }
+
+    /**
+     * Reset the parser and the found status to parse the new JSON data.
+     */
+    void reset()
+    {
+        state = st_value;
+        depth = 0;
+        arrayBits = 0;
+        keyLen = 0;
+        keyMask = 0;
+        valueMask = 0;
+        uIndex = 0;
+        uCode = 0;
+        started = false;
+        levelMask[0] = fieldMask();
+        for (uint8_t i = 0; i < count; i++)
+        {
+            fields[i].len = 0;
+            fields[i].found = false;
+            fields[i].type = mb_json_extractor_type_undefined;
+            if (fields[i].buf && fields[i].size > 0)
+                fields[i].buf[0] = '\0';
+        }
+    }
+
+    /**
+     * Parse the JSON data.
+     * @param data The JSON data.
+     * @param len The length of data.
+     * @return The number of bytes that were parsed.
+     */
+    size_t parse(const char *data, size_t len)
+    {
+        size_t i = 0;
+        while (i < len && state != st_done && state != st_error)
+        {
+            // the plain string data span is passed at once
+            if ((state == st_string || state == st_key) && data[i] != '"' && data[i] != '\\')
+            {
+                size_t n = 1;
+                while (i + n < len && data[i + n] != '"' && data[i + n] != '\\')
+                    n++;
+                if (state == st_string)
+                    output(data + i, n);
+                else
+                    matchKey(data + i, n);
+                i += n;
+                continue;
+            }
+
+            parseChar(data[i++]);
+        }
+        return i;
+    }
+
+    /* the JSON root value was completely parsed */
+    bool complete() const { return state == st_done; }
+
+    bool error() const { return state == st_error; }
+
+    /* any JSON data was parsed */
+    bool isStarted() const { return started; }
+
+    /* the value of the field was found */
+    bool found(int index) const { return index > -1 && index < count && fields[index].found; }
+
+    /* the value type of the field */
+    mb_json_extractor_value_type type(int index) const { return found(index) ? fields[index].type : mb_json_extractor_type_undefined; }
+
+    /* the length of the field value, it can be larger than the output buffer */
+    size_t length(int index) const { return found(index) ? fields[index].len : 0; }
+
+    /* the value of the field in its buffer */
+    const char *value(int index) const { return found(index) && fields[index].buf ? fields[index].buf : ""; }
+
+    /**
+     * Append the data to string without the null-terminated source.
+     * @param str The string to append.
+     * @param data The data.
+     * @param len The length of data.
+     */
+    static void appendString(MB_String &str, const char *data, size_t len)
+    {
+        char temp[65];
+        str.reserve(str.length() + len);
+        while (len > 0)
+        {
+            size_t n = len < sizeof(temp) - 1 ? len : sizeof(temp) - 1;
+            memcpy(temp, data, n);
+            temp[n] = '\0';
+            str += temp;
+            data += n;
+            len -= n;
+        }
+    }
+
+private:
+    enum parser_state
+    {
+        st_value,
+        st_object_begin, // after '{', the key or '}'
+        st_key,
+        st_key_escape,
+        st_colon,
+        st_string,
+        st_string_escape,
+        st_string_unicode,
+        st_literal,
+        st_after_value,
+        st_done,
+        st_error
+    };
+
+    mb_json_extractor_field_t fields[MB_JSON_EXTRACTOR_MAX_FIELDS];
+    uint8_t count = 0;
+
+    parser_state state = st_value;
+    uint8_t depth = 0;
+    // one bit per nesting level, set for array
+    uint32_t arrayBits = 0;
+    // the fields that their path matched the keys of each object level
+    uint32_t levelMask[MB_JSON_EXTRACTOR_MAX_PATH_DEPTH + 1];
+    // the fields that their current segment is matching the key being parsed
+    uint32_t keyMask = 0;
+    size_t keyLen = 0;
+    // the fields that receive the value being parsed
+    uint32_t valueMask = 0;
+    uint8_t uIndex = 0;
+    uint16_t uCode = 0;
+    bool started = false;
+
+    uint32_t fieldMask() const { return count >= 32 ? 0xffffffff : (1UL << count) - 1; }
+
+    bool inArray() const { return depth > 0 && (arrayBits & (1UL << (depth - 1))); }
+
+    // the key segment index of the current object level
+    uint32_t currentMask() const { return depth <= MB_JSON_EXTRACTOR_MAX_PATH_DEPTH && !inArray() ? levelMask[depth - 1] : 0; }
+
+    void matchKey(const char *s, size_t n)
+    {
+        for (uint8_t k = 0; k < count && keyMask; k++)
+        {
+            if (!(keyMask & (1UL << k)))
+                continue;
+
+            mb_json_extractor_field_t &f = fields[k];
+            uint8_t seg = depth - 1;
+            if (keyLen + n > f.segLen[seg] || strncmp_P(s, f.path + f.segOffset[seg] + keyLen, n) != 0)
+                keyMask &= ~(1UL << k);
+        }
+        keyLen += n;
+    }
+
+    void keyEnded()
+    {
+        uint8_t seg = depth - 1;
+        uint32_t leaf = 0, parent = 0;
+        for (uint8_t k = 0; k < count; k++)
+        {
+            if (!(keyMask & (1UL << k)) || fields[k].segLen[seg] != keyLen)
+                continue;
+
+            if (fields[k].segCount == seg + 1)
+                leaf |= 1UL << k;
+            else
+                parent |= 1UL << k;
+        }
+        valueMask = leaf;
+        // the fields which match the next object level
+        if (depth < MB_JSON_EXTRACTOR_MAX_PATH_DEPTH + 1)
+            levelMask[depth] = parent;
+    }
+
+    void valueBegin(mb_json_extractor_value_type type)
+    {
+        started = true;
+        for (uint8_t k = 0; k < count; k++)
+        {
+            if (valueMask & (1UL << k))
+            {
+                fields[k].found = true;
+                fields[k].type = type;
+                fields[k].len = 0;
+            }
+        }
+    }
+
+    void output(const char *s, size_t n)
+    {
+        for (uint8_t k = 0; k < count && valueMask; k++)
+        {
+            if (!(valueMask & (1UL << k)))
+                continue;
+
+            mb_json_extractor_field_t &f = fields[k];
+
+            if (f.buf && f.size > 0 && f.len < f.size - 1)
+            {
+                size_t m = f.size - 1 - f.len < n ? f.size - 1 - f.len : n;
+                memcpy(f.buf + f.len, s, m);
+                f.buf[f.len + m] = '\0';
+            }
+
+            if (f.str)
+                appendString(*f.str, s, n);
+
+            if (f.cb)
+                f.cb(f.arg, s, n);
+
+            f.len += n;
+        }
+    }
+
+    void outputChar(char c) { output(&c, 1); }
+
+    // UTF-8 encode the \uXXXX code point (surrogate pairs are passed as is)
+    void outputCode(uint16_t code)
+    {
+        char u[3];
+        if (code < 0x80)
+            outputChar(code);
+        else if (code < 0x800)
+        {
+            u[0] = 0xc0 | (code >> 6);
+            u[1] = 0x80 | (code & 0x3f);
+            output(u, 2);
+        }
+        else
+        {
+            u[0] = 0xe0 | (code >> 12);
+            u[1] = 0x80 | ((code >> 6) & 0x3f);
+            u[2] = 0x80 | (code & 0x3f);
+            output(u, 3);
+        }
+    }
+
+    bool push(bool isArray)
+    {
+        if (depth >= MB_JSON_EXTRACTOR_MAX_DEPTH)
+        {
+            state = st_error;
+            return false;
+        }
+
+        if (isArray)
+            arrayBits |= 1UL << depth;
+        else
+            arrayBits &= ~(1UL << depth);
+
+        // the root object matches all fields
+        if (depth == 0)
+            levelMask[0] = fieldMask();
+        else if (isArray || depth > MB_JSON_EXTRACTOR_MAX_PATH_DEPTH || inArray())
+        {
+            if (depth < MB_JSON_EXTRACTOR_MAX_PATH_DEPTH + 1)
+                levelMask[depth] = 0;
+        }
+
+        depth++;
+        valueMask = 0;
+        return true;
+    }
+
+    void pop()
+    {
+        depth--;
+        valueMask = 0;
+        state = depth == 0 ? st_done : st_after_value;
+    }
+
+    bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+
+    bool isLiteral(char c) { return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || c == '-' || c == '+' || c == '.' || c == 'E'; }
+
+    void parseChar(char c)
+    {
+        switch (state)
+        {
+        case st_value:
+            if (isSpace(c))
+                break;
+            if (c == '{')
+            {
+                valueBegin(mb_json_extractor_type_object);
+                if (push(false))
+                    state = st_object_begin;
+            }
+            else if (c == '[')
+            {
+                valueBegin(mb_json_extractor_type_array);
+                if (push(true))
+                    state = st_value;
+            }
+            else if (c == ']' && inArray())
+                pop();
+            else if (c == '"')
+            {
+                valueBegin(mb_json_extractor_type_string);
+                state = st_string;
+            }
+            else if (isLiteral(c))
+            {
+                valueBegin(mb_json_extractor_type_literal);
+                outputChar(c);
+                state = st_literal;
+            }
+            else
+                state = st_error;
+            break;
+
+        case st_object_begin:
+            if (isSpace(c))
+                break;
+            if (c == '"')
+            {
+                keyMask = currentMask();
+                keyLen = 0;
+                state = st_key;
+            }
+            else if (c == '}')
+                pop();
+            else
+                state = st_error;
+            break;
+
+        case st_key:
+            if (c == '"')
+            {
+                keyEnded();
+                state = st_colon;
+            }
+            else if (c == '\\')
+                state = st_key_escape;
+            break;
+
+        case st_key_escape:
+            // the escaped key character is matched as it is
+            matchKey(&c, 1);
+            state = st_key;
+            break;
+
+        case st_colon:
+            if (isSpace(c))
+                break;
+            state = c == ':' ? st_value : st_error;
+            break;
+
+        case st_string:
+            if (c == '"')
+            {
+                valueMask = 0;
+                state = depth == 0 ? st_done : st_after_value;
+            }
+            else if (c == '\\')
+                state = st_string_escape;
+            break;
+
+        case st_string_escape:
+            state = st_string;
+            switch (c)
+            {
+            case 'n':
+                outputChar('\n');
+                break;
+            case 'r':
+                outputChar('\r');
+                break;
+            case 't':
+                outputChar('\t');
+                break;
+            case 'b':
+                outputChar('\b');
+                break;
+            case 'f':
+                outputChar('\f');
+                break;
+            case 'u':
+                uIndex = 0;
+                uCode = 0;
+                state = st_string_unicode;
+                break;
+            default:
+                // \" \\ \/
+                outputChar(c);
+                break;
+            }
+            break;
+
+        case st_string_unicode:
+        {
+            uint8_t v = 0;
+            if (c >= '0' && c <= '9')
+                v = c - '0';
+            else if (c >= 'a' && c <= 'f')
+                v = c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F')
+                v = c - 'A' + 10;
+            else
+            {
+                state = st_error;
+                break;
+            }
+            uCode = (uCode << 4) | v;
+            if (++uIndex == 4)
+            {
+                outputCode(uCode);
+                state = st_string;
+            }
+            break;
+        }
+
+        case st_literal:
+            if (isLiteral(c))
+            {
+                outputChar(c);
+                break;
+            }
+            valueMask = 0;
+            if (depth == 0)
+            {
+                state = st_done;
+                break;
+            }
+            state = st_after_value;
+            parseChar(c);
+            break;
+
+        case st_after_value:
+            if (isSpace(c))
+                break;
+            if (c == ',')
+                state = inArray() ? st_value : st_object_begin;
+            else if ((c == '}' && !inArray()) || (c == ']' && inArray()))
+                pop();
+            else
+                state = st_error;
+            break;
+
+        default:
+            break;
+        }
+    }
+};
+
+#endif